@@ -0,0 +1,55 @@
+#ifndef GOSHOP_CONCURRENTDISJOINTSET_H
+#define GOSHOP_CONCURRENTDISJOINTSET_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "ThreadPool.h"
+using namespace std;
+// Lock-free union-find over the ids [0, n), for bulk merges such as the nightly
+// category reconciliation. find, unite and sameSet may run concurrently from any
+// number of threads:
+//  - find is wait-free: it walks up the parent array and splits the path with one
+//    CAS per step, which may fail harmlessly when another thread got there first
+//  - unite links one root under the other with a CAS, retrying if either root was
+//    linked meanwhile. Roots are ordered by a fixed pseudo-random priority of their
+//    id (randomized linking), which keeps trees shallow without storing ranks.
+// Unlike DisjointSet there are no names and no removal; DisjointSet::unionBatch
+// runs its merges through this class.
+class ConcurrentDisjointSet {
+private:
+    unique_ptr<atomic<uint32_t>[]> parent;  // parent[id] == id for roots
+    size_t count;                           // number of ids
+    atomic<size_t> sets;                    // number of sets (components)
+
+    // Linking priority of id; a bijection, so two roots never tie
+    static uint32_t priority(uint32_t id);
+
+public:
+    // Constructor: n singleton sets
+    explicit ConcurrentDisjointSet(size_t n);
+
+    ConcurrentDisjointSet(const ConcurrentDisjointSet&) = delete;
+    ConcurrentDisjointSet& operator=(const ConcurrentDisjointSet&) = delete;
+
+    // Root of id's set (the root may change as soon as another unite links it)
+    uint32_t find(uint32_t id);
+    // Merge the sets of a and b (false if already together)
+    bool unite(uint32_t a, uint32_t b);
+    // True if a and b are in the same set at some point during the call
+    bool sameSet(uint32_t a, uint32_t b);
+
+    // Unite every edge, splitting the list across the pool's workers. Returns the
+    // number of connected components afterwards.
+    size_t unionBatch(const vector<pair<uint32_t, uint32_t>>& edges,
+                      ThreadPool& pool = ThreadPool::shared());
+
+    // Number of ids, and of sets (connected components)
+    size_t size() const { return count; }
+    size_t components() const { return sets.load(); }
+};
+
+#endif // GOSHOP_CONCURRENTDISJOINTSET_H
@@ -0,0 +1,84 @@
+#ifndef GOSHOP_CONCURRENTSKIPLIST_H
+#define GOSHOP_CONCURRENTSKIPLIST_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+using namespace std;
+// Lock-free skip list with the same aisle -> description interface as SkipList, for
+// kiosks that look aisles up while the inventory feed edits them. insert, search,
+// update and remove may run concurrently from any number of threads:
+//  - links are CASed into place; a node is deleted by first marking its forward
+//    links (logical delete), after which any traversal may unlink it physically
+//  - unlinked nodes and replaced values are freed through epoch-based reclamation,
+//    so a reader never touches freed memory
+//  - node levels come from a thread-local generator instead of the global rand()
+// Unlike SkipList, failed operations only return false: under concurrency a missing
+// or duplicate key is routine, so nothing is printed.
+class ConcurrentSkipList {
+private:
+    struct Node {
+        int key;
+        atomic<const string*> value;     // replaced wholesale by update
+        int height;                      // number of levels the node is linked on
+        atomic<uintptr_t>* next;         // forward links; bit 0 marks a logical delete
+        atomic<unsigned> state;          // INSERTING / REMOVED handshake for retirement
+        Node(int k, const string* val, int h);
+        ~Node();
+    };
+
+    // Node::state bits: the inserter may still be linking upper levels, and the
+    // remover has finished unlinking. Whoever leaves the node with REMOVED alone
+    // hands it to the reclaimer, so a node is never freed while still being linked.
+    static const unsigned INSERTING;
+    static const unsigned REMOVED;
+
+    // Maximum number of levels (enough for millions of keys with P = 0.5)
+    static constexpr int MAX_HEIGHT = 24;
+
+    Node* head;              // sentinel linked on every level
+    atomic<size_t> count;    // number of keys currently present
+
+    // Helpers for the marked forward links
+    static Node* pointer(uintptr_t link);
+    static bool marked(uintptr_t link);
+
+    // Random node height in [1, MAX_HEIGHT] from the calling thread's generator
+    static int randomHeight();
+    // Locate key: preds/succs receive the neighbours on every level. Marked nodes
+    // met on the way are unlinked. Returns true if an unmarked node with key exists
+    // (it is then succs[0]).
+    bool find(int key, Node** preds, Node** succs) const;
+    // Hand a fully unlinked node to the reclaimer
+    static void retire(Node* node);
+
+public:
+    // Constructor: empty list
+    ConcurrentSkipList();
+    // Destructor: free all nodes (no other thread may still be using the list)
+    ~ConcurrentSkipList();
+
+    ConcurrentSkipList(const ConcurrentSkipList&) = delete;
+    ConcurrentSkipList& operator=(const ConcurrentSkipList&) = delete;
+
+    // Insert a key-value pair (returns false if key exists)
+    bool insert(int key, const string& value);
+
+    // Search for a key, output a copy of its value in outValue if found
+    bool search(int key, string& outValue) const;
+
+    // Replace the value of an existing key
+    bool update(int key, const string& newValue);
+
+    // Remove a key-value pair
+    bool remove(int key);
+
+    // Number of keys (exact when no operation is in flight)
+    size_t size() const;
+
+    // Display all elements in key order; concurrent edits may or may not show up
+    void displayList() const;
+};
+
+#endif // GOSHOP_CONCURRENTSKIPLIST_H
@@ -1,27 +1,225 @@
 #ifndef GOSHOP_DISJOINTSET_H
 #define GOSHOP_DISJOINTSET_H
 
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
+#include <iterator>
 #include <string>
-#include <map>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 using namespace std;
 
+// Union-find over dense uint32_t element ids with union by rank and path halving;
+// item names are interned to ids on makeSet, so the string API below is a lookup
+// in one hash map followed by array walks on the id engine.
+//
+// Removal uses vacant nodes: a removed item gives up its name but its node stays in
+// the tree (and in its set's member ring) so paths through it keep working. Once
+// more than half of a set's nodes are vacant the set is rebuilt as a star over its
+// remaining items and the vacant ids are recycled, so removal stays amortized
+// near-constant. compact() renumbers everything densely and releases memory.
+//
+// The ring also makes a set's contents cheap to list: members(), setSize() and
+// iterating a set cost O(set size), independent of the catalog size.
 class DisjointSet {
+public:
+    // Id returned for names that were never added
+    static constexpr uint32_t NO_ID = UINT32_MAX;
+
 private:
-    map<string, string> parent;
-    map<string, int> rank;
-    map<string, bool> active; // new: track if an item is removed
+    // State of an id
+    enum class Slot : uint8_t {
+        Free,      // unused, waiting in freeIds
+        Occupied,  // holds an item
+        Vacant     // item removed, node still linked into its set
+    };
+
+    // Id engine: parent[id] == id for roots
+    vector<uint32_t> parent;
+    vector<uint8_t> rank;   // at most log2(element count), so a byte is plenty
+    vector<uint32_t> next;  // circular list of all nodes (vacant ones too) in a set
+    vector<Slot> slots;
+    vector<uint32_t> freeIds;
+
+    // Per-set data, valid at roots only
+    vector<uint32_t> leader;  // occupied id whose name represents the set
+    vector<uint32_t> items;   // occupied nodes in the set
+    vector<uint32_t> nodes;   // occupied and vacant nodes in the set
+
+    // Interning layer: name of each occupied id and id of each name
+    vector<string> names;
+    unordered_map<string, uint32_t> ids;
 
-    string findSet(const string& x);
+    // Number of non-empty sets
+    size_t setCount = 0;
+
+    // Id of item x; prints an error and returns NO_ID if it is missing
+    uint32_t existingId(const string& x) const;
+    // Take a free id (or a new one) as a singleton set
+    uint32_t allocateId();
+    // Root of id's set without path halving, so concurrent readers may call it
+    uint32_t rootOf(uint32_t id) const;
+    // Relink the items of root's set as a star under its leader and free its vacant
+    // ids; returns the new root
+    uint32_t rebuildSet(uint32_t root);
 
 public:
+    class SetIterator;
+
+    // One set, as produced by iterating the DisjointSet. Iterating a Set yields the
+    // names of its items in ring order.
+    class Set {
+    public:
+        class iterator {
+        public:
+            typedef forward_iterator_tag iterator_category;
+            typedef string value_type;
+            typedef ptrdiff_t difference_type;
+            typedef const string* pointer;
+            typedef const string& reference;
+
+            iterator() : owner(nullptr), root(NO_ID), node(NO_ID) {}
+            reference operator*() const { return owner->names[node]; }
+            pointer operator->() const { return &owner->names[node]; }
+            iterator& operator++() {
+                advance();
+                return *this;
+            }
+            iterator operator++(int) {
+                iterator old = *this;
+                advance();
+                return old;
+            }
+            friend bool operator==(const iterator& a, const iterator& b) {
+                return a.node == b.node;
+            }
+            friend bool operator!=(const iterator& a, const iterator& b) {
+                return a.node != b.node;
+            }
+
+        private:
+            friend class Set;
+            iterator(const DisjointSet* ds, uint32_t r) : owner(ds), root(r), node(r) {
+                if (owner->slots[node] != Slot::Occupied) advance();
+            }
+            // Step along the ring to the next occupied node; NO_ID after a full lap
+            void advance() {
+                do {
+                    node = owner->next[node];
+                } while (node != root && owner->slots[node] != Slot::Occupied);
+                if (node == root) node = NO_ID;
+            }
+            const DisjointSet* owner;
+            uint32_t root;
+            uint32_t node;  // NO_ID at the end
+        };
+
+        // Name of the item representing the set
+        const string& representative() const { return owner->names[owner->leader[root]]; }
+        // Number of items in the set
+        size_t size() const { return owner->items[root]; }
+        iterator begin() const { return iterator(owner, root); }
+        iterator end() const { return iterator(); }
+
+    private:
+        friend class DisjointSet;
+        friend class SetIterator;
+        Set(const DisjointSet* ds, uint32_t r) : owner(ds), root(r) {}
+        const DisjointSet* owner;
+        uint32_t root;
+    };
+
+    // Forward iterator over all sets (in root id order). Any change to the
+    // DisjointSet invalidates it.
+    class SetIterator {
+    public:
+        typedef forward_iterator_tag iterator_category;
+        typedef Set value_type;
+        typedef ptrdiff_t difference_type;
+        typedef const Set* pointer;
+        typedef Set reference;
+
+        reference operator*() const { return Set(owner, root); }
+        SetIterator& operator++() {
+            root++;
+            skipToRoot();
+            return *this;
+        }
+        SetIterator operator++(int) {
+            SetIterator old = *this;
+            ++*this;
+            return old;
+        }
+        friend bool operator==(const SetIterator& a, const SetIterator& b) {
+            return a.root == b.root;
+        }
+        friend bool operator!=(const SetIterator& a, const SetIterator& b) {
+            return a.root != b.root;
+        }
+
+    private:
+        friend class DisjointSet;
+        SetIterator(const DisjointSet* ds, uint32_t r) : owner(ds), root(r) { skipToRoot(); }
+        // Move to the first root at or after root (or to the end)
+        void skipToRoot() {
+            while (root < owner->parent.size() &&
+                   (owner->slots[root] == Slot::Free || owner->parent[root] != root)) {
+                root++;
+            }
+        }
+        const DisjointSet* owner;
+        uint32_t root;
+    };
+
+    // Add item x as a singleton set
     bool makeSet(const string& x);
+    // Representative of item x
     bool find(const string& x, string& outRepresentative);
+    // Merge the sets of items x and y (false if already together)
     bool unionSets(const string& x, const string& y);
-    bool removeItem(const string& x);             // new
-    bool updateItem(const string& oldName, const string& newName); // new
+    // Merge the sets of every (x, y) pair. Names are resolved and the merges linked
+    // in parallel on the shared ThreadPool (see ConcurrentDisjointSet), then folded
+    // back in one pass. Pairs naming missing items are skipped and reported in one
+    // summary line. Returns the number of sets afterwards.
+    size_t unionBatch(const vector<pair<string, string>>& pairs);
+    // Delete item x; if it represented its set another member takes over
+    bool removeItem(const string& x);
+    // Rename an item in place (its set is unchanged)
+    bool updateItem(const string& oldName, const string& newName);
     void printSets();
+
+    // Items in the same set as x (x included)
+    bool members(const string& x, vector<string>& outMembers);
+    // Number of items in the same set as x
+    bool setSize(const string& x, size_t& outSize);
+    // Number of sets
+    size_t numSets() const { return setCount; }
+    // Iteration over all sets
+    SetIterator begin() const { return SetIterator(this, 0); }
+    SetIterator end() const { return SetIterator(this, static_cast<uint32_t>(parent.size())); }
+
+    // Renumber the items densely, drop all vacant and free ids and release the
+    // spare memory. Ids handed out before are invalidated.
+    void compact();
+
+    // Reserve room for n items
+    void reserve(size_t n);
+    // Number of items, and of ids in use or waiting for reuse
+    size_t size() const { return ids.size(); }
+    size_t idCount() const { return parent.size(); }
+
+    // Id of item x, or NO_ID if there is no such item
+    uint32_t idOf(const string& x) const;
+    // Name of an occupied id
+    const string& nameOf(uint32_t id) const { return names[id]; }
+    // Root id of id's set, halving the path on the way up
+    uint32_t findRoot(uint32_t id);
+    // Occupied id representing id's set
+    uint32_t representative(uint32_t id) { return leader[findRoot(id)]; }
+    // Merge the sets of two occupied ids by rank (false if already together)
+    bool unionIds(uint32_t a, uint32_t b);
 };
 
 #endif // GOSHOP_DISJOINTSET_H
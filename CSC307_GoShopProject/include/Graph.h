@@ -8,35 +8,338 @@
 #include <limits>
 #include <queue>
 #include <utility>
+#include <cstdint>
+#include <unordered_map>
+#include <list>
+#include <mutex>
+#include <functional>
+#include <type_traits>
+#include "PriorityQueues.h"
 using namespace std;
-class Graph {
+
+// Arithmetic on edge weights and path lengths. Integer sums saturate at the type's
+// maximum and floating-point sums overflow to infinity, so an overlong path reads as
+// unreachable instead of wrapping around to a short one.
+template <typename Weight>
+struct WeightTraits {
+    static_assert(is_arithmetic_v<Weight> && is_signed_v<Weight>,
+                  "Graph weights must be a signed integer or floating-point type");
+
+    // Length of a path to an unreachable vertex (also larger than any edge weight)
+    static constexpr Weight infinity() {
+        if constexpr (is_floating_point_v<Weight>) {
+            return numeric_limits<Weight>::infinity();
+        } else {
+            return numeric_limits<Weight>::max();
+        }
+    }
+
+    // a + b for non-negative a and b, clamped to infinity()
+    static constexpr Weight add(Weight a, Weight b) {
+        if constexpr (is_integral_v<Weight>) {
+            return (a > infinity() - b) ? infinity() : a + b;
+        } else {
+            return a + b;
+        }
+    }
+};
+
+// Store map as an undirected weighted graph. Weight is the type of edge weights and
+// path lengths: int32_t, int64_t, float or double (see Graph for the usual int map).
+template <typename Weight>
+class BasicGraph {
+public:
+    // Distance reported for unreachable vertices
+    static constexpr Weight UNREACHABLE = WeightTraits<Weight>::infinity();
+
+    // Search strategy used by findShortestPath
+    enum class QueryMode {
+        Dijkstra,       // plain Dijkstra from start, stops once end is settled
+        Bidirectional,  // Dijkstra from both ends at once, stops when the frontiers meet
+        AStar,          // goal-directed Dijkstra guided by vertex coordinates
+        ContractionHierarchy  // upward search in the prebuilt hierarchy (Dijkstra if stale)
+    };
+
+    // Priority queue a search ran on. The Dijkstra kernels pick one from the largest
+    // edge weight; the other modes always use a binary heap.
+    enum class QueueKind {
+        BinaryHeap,   // std::priority_queue with lazy deletion
+        Buckets,      // Dial's monotone bucket queue (every edge weight is small)
+        IndexedHeap   // indexed 4-ary heap with decrease-key (fallback for large weights)
+    };
+
+    // Per-query statistics so the search modes can be compared
+    struct QueryStats {
+        size_t settledVertices = 0;  // vertices finalized by the search (both sides if bidirectional)
+        QueueKind queue = QueueKind::BinaryHeap;
+    };
+
+    // One edit in a batch passed to applyEdits (dest/weight unused where not needed)
+    struct GraphEdit {
+        enum Kind { AddVertex, RemoveVertex, AddEdge, RemoveEdge, UpdateEdge };
+        Kind kind;
+        string src;
+        string dest;
+        Weight weight = 0;
+    };
+
+    // Counters of the result cache behind the plain findShortestPath
+    struct PathCacheStats {
+        size_t hits = 0;           // answered from a cached (start, end) result
+        size_t treeHits = 0;       // answered from the cached shortest-path tree of start
+        size_t misses = 0;         // had to run a search
+        size_t evictions = 0;      // entries pushed out by the capacity limit
+        size_t invalidations = 0;  // entries and trees dropped because an edit affected them
+    };
+
 private:
-    // Adjacency list representation: map from vertex label to vector of (neighbor, weight) pairs
-    map<string, vector<pair<string, int>>> adjList;
+    typedef WeightTraits<Weight> Traits;
+
+    // Adjacency list representation: map from vertex label to a hash map of neighbor -> weight.
+    // Both directions of an undirected edge are stored, so a vertex's entry lists exactly
+    // the vertices that refer to it.
+    map<string, unordered_map<string, Weight>> adjList;
+    // Optional (x, y) position of each vertex, used by the A* heuristic
+    map<string, pair<double, double>> coords;
+
+    // Frozen compressed-sparse-row (CSR) snapshot of adjList used by the path queries.
+    // Vertex labels are interned to dense ids; the edges of vertex v are stored in
+    // neighbors/weights at indices [offsets[v], offsets[v + 1]).
+    struct CompiledGraph {
+        vector<string> labels;                // id -> vertex label
+        unordered_map<string, uint32_t> ids;  // vertex label -> id
+        vector<uint32_t> offsets;             // size = number of vertices + 1
+        vector<uint32_t> neighbors;           // neighbor id of each edge slot
+        vector<Weight> weights;               // weight of each edge slot
+        // Coordinates by id; A* only uses them when every vertex has a position
+        vector<double> xs, ys;
+        bool hasCoords = false;
+        // Largest s with weight >= s * euclidean length on every edge, so that
+        // s * euclidean distance to the target is an admissible, consistent heuristic
+        double heuristicScale = 0.0;
+        // Upper bound on the edge weights (exact after compile, raised by in-place patches)
+        Weight maxWeight = 0;
+    };
+
+    // Contraction hierarchy over the compiled ids. Every vertex gets a rank (its
+    // contraction order); the upward graph keeps, for each vertex, the original
+    // edges and shortcuts leading to higher-ranked vertices, in CSR layout.
+    struct ContractionHierarchy {
+        vector<uint32_t> rank;        // id -> contraction order
+        vector<uint32_t> upOffsets;   // size = number of vertices + 1
+        vector<uint32_t> upTargets;   // higher-ranked endpoint of each upward edge
+        vector<Weight> upWeights;     // length of each upward edge
+        vector<uint32_t> upMiddle;    // vertex a shortcut bypasses (NO_VERTEX for an original edge)
+        size_t shortcutCount = 0;
+    };
+
+    // Reusable buffers for the Dijkstra kernels, one set per thread.
+    // 'dist' is INF everywhere except at the ids listed in 'touched'.
+    struct SearchScratch {
+        vector<Weight> dist;
+        vector<uint32_t> touched;
+        vector<char> isTarget;
+        BucketQueue<Weight> buckets;  // only used for integer weights
+        IndexedHeap<Weight> indexed;
+        // Size the buffers for n vertices and wipe what the last search left behind
+        void prepare(size_t n);
+    };
+
+    // Sentinel id for "no vertex" (e.g. the parent of the search source)
+    static constexpr uint32_t NO_VERTEX = UINT32_MAX;
+
+    mutable CompiledGraph compiled;
+    mutable bool compiledDirty = true;  // set by every edit, cleared by compile()
+
+    ContractionHierarchy hierarchy;
+    bool hierarchyStale = true;  // set by every edit, cleared by buildContractionHierarchy()
+
+    // Result cache for findShortestPath. Pairs live in an LRU list (most recent first);
+    // sources that keep missing get their full shortest-path tree cached, so any
+    // destination from them is answered without a search. Edits drop only what they
+    // can affect: a longer or removed edge invalidates results whose path uses it, a
+    // shorter or new edge invalidates results it could improve.
+    struct CachedPath {
+        string start, end;
+        vector<string> path;
+        Weight distance;
+    };
+    struct CachedTree {
+        uint32_t source;            // compiled id of the tree's root
+        uint64_t vertexSetVersion;  // ids are only valid while the vertex set is unchanged
+        vector<Weight> dist;
+        vector<uint32_t> prev;
+    };
+    static const size_t HOT_SOURCE_THRESHOLD;  // misses from one start before its tree is cached
+    static const size_t HOT_TREE_CAPACITY;     // number of cached trees
+    // Largest edge weight for which the Dijkstra kernels use the bucket queue (integer weights)
+    static const int BUCKET_QUEUE_MAX_WEIGHT;
+
+    mutable mutex cacheLock;  // guards everything below
+    mutable list<CachedPath> pathCache;
+    mutable unordered_map<string, typename list<CachedPath>::iterator> pathCacheIndex;  // key: start '\0' end
+    mutable list<CachedTree> treeCache;                                        // most recent first
+    mutable unordered_map<string, size_t> sourceMisses;
+    // Trees of watched sources, repaired in place after every edge edit
+    mutable map<string, CachedTree> watchedTrees;
+    mutable PathCacheStats cacheStats;
+    size_t pathCacheCapacity = 1024;
+    uint64_t vertexSetVersion = 0;  // bumped when vertices are added or removed (compiled ids shift)
+
+    // Invalidate everything derived from adjList after an edit
+    void markEdited();
+    // Write a new weight for edge u-v straight into a clean compiled snapshot so a
+    // weight change does not force a recompile. Returns false if it must be rebuilt.
+    bool patchCompiledWeight(const string& u, const string& v, Weight newWeight);
+    // Reject negative, NaN and infinite weights with a message
+    static bool checkWeight(Weight weight);
+    // Cache maintenance for an edge whose weight went from oldWeight to newWeight
+    // (UNREACHABLE standing for "no edge" on either side)
+    void invalidateCachesForEdge(const string& u, const string& v,
+                                 Weight oldWeight, Weight newWeight);
+    // Drop cached results whose path visits a vertex matching 'removed'
+    void invalidateCachesForVertices(const function<bool(const string&)>& removed);
+    // Bring the watched trees up to date after edge u-v went from oldWeight to newWeight
+    void repairWatchedTrees(const string& u, const string& v, Weight oldWeight, Weight newWeight);
+    // Incremental repairs (Ramalingam-Reps) of a tree whose compiled edge u-v got longer
+    // or disappeared, or got shorter or appeared with the given weight. Both only touch
+    // the vertices whose distance actually changes.
+    void repairTreeAfterIncrease(const CompiledGraph& g, CachedTree& tree,
+                                 uint32_t u, uint32_t v) const;
+    void repairTreeAfterDecrease(const CompiledGraph& g, CachedTree& tree,
+                                 uint32_t u, uint32_t v, Weight weight) const;
+    // True if a cached tree still holds after edge u-v changed from oldWeight to newWeight
+    bool treeSurvivesEdgeChange(const CachedTree& tree, uint32_t u, uint32_t v,
+                                Weight oldWeight, Weight newWeight) const;
+
+    // Return the compiled snapshot, rebuilding it first if adjList was edited.
+    const CompiledGraph& compiledView() const;
+
+    // Search kernels over compiled ids. Each fills idPath (source..target) and
+    // distance, and returns false if target is unreachable.
+    bool dijkstraSearch(const CompiledGraph& g, uint32_t source, uint32_t target,
+                        vector<uint32_t>& idPath, Weight& distance, QueryStats& stats) const;
+    bool bidirectionalSearch(const CompiledGraph& g, uint32_t source, uint32_t target,
+                             vector<uint32_t>& idPath, Weight& distance, QueryStats& stats) const;
+    bool aStarSearch(const CompiledGraph& g, uint32_t source, uint32_t target,
+                     vector<uint32_t>& idPath, Weight& distance, QueryStats& stats) const;
+    bool hierarchySearch(const CompiledGraph& g, uint32_t source, uint32_t target,
+                         vector<uint32_t>& idPath, Weight& distance, QueryStats& stats) const;
+    // Single-source Dijkstra filling distances and parents of every vertex. If
+    // 'targets' is given (a per-id flag array), the search stops as soon as all
+    // 'targetCount' flagged vertices are settled. Returns the queue it used.
+    QueueKind shortestPathTree(const CompiledGraph& g, uint32_t source,
+                               vector<Weight>& dist, vector<uint32_t>& prev,
+                               const vector<char>* targets = nullptr, size_t targetCount = 0) const;
+    // Dijkstra from source over the thread's scratch buffers. Stops early once the
+    // 'targetCount' vertices flagged in scratch.isTarget are settled (0 = run fully).
+    QueueKind distanceSweep(const CompiledGraph& g, uint32_t source, SearchScratch& scratch,
+                            size_t targetCount) const;
+    // Reset the scratch queue suited to g's edge weights and pass it to 'search'
+    template <typename Search>
+    QueueKind withDijkstraQueue(const CompiledGraph& g, SearchScratch& scratch,
+                                Search search) const;
+    // Scratch buffers of the calling thread
+    static SearchScratch& threadScratch();
+    // Expand an upward edge (possibly a shortcut) from -> to into original vertices,
+    // appending everything after 'from' up to and including 'to' to idPath.
+    void unpackHierarchyEdge(uint32_t from, uint32_t to, uint32_t middle,
+                             vector<uint32_t>& idPath) const;
 
 public:
     // Add a vertex (location) to the graph.
     bool addVertex(const string& label);
+    // Add a vertex with a position on the floor plan (enables the A* query mode).
+    // Edge weights should be at least the straight-line distance for the best guidance.
+    bool addVertex(const string& label, double x, double y);
 
     // Remove a vertex and all associated edges from the graph.
     bool removeVertex(const string& label);
 
+    // Remove a batch of vertices (e.g. a store remodel) in one pass; edges between two
+    // removed vertices are never unlinked individually. Returns how many were removed.
+    size_t removeVertices(const vector<string>& labels);
+
     // Add an undirected edge (path) between src and dest with given weight (distance).
-    bool addEdge(const string& src, const string& dest, int weight);
+    // Fails if the two vertices are already connected (use updateEdge to change it).
+    bool addEdge(const string& src, const string& dest, Weight weight);
 
     // Remove an undirected edge (path) between src and dest.
     bool removeEdge(const string& src, const string& dest);
 
     // Update the weight (distance) of an existing edge between src and dest.
-    bool updateEdge(const string& src, const string& dest, int newWeight);
+    bool updateEdge(const string& src, const string& dest, Weight newWeight);
+
+    // Apply a batch of edits in order; runs of RemoveVertex edits are grouped into one
+    // removeVertices pass. Returns the number of edits that succeeded.
+    size_t applyEdits(const vector<GraphEdit>& edits);
 
     // Print the graph (list all vertices and their adjacent vertices with weights).
     void printGraph() const;
 
+    // Freeze the current adjacency list into the compiled representation now.
+    // Queries do this lazily on first use after an edit, so calling it is optional.
+    void compile() const;
+
+    // Preprocess the current graph into a contraction hierarchy (vertex ordering plus
+    // shortcut edges) so QueryMode::ContractionHierarchy queries become very cheap.
+    // Any edit marks the hierarchy stale; such queries then use plain Dijkstra until
+    // this is called again. Returns the number of shortcuts added.
+    size_t buildContractionHierarchy();
+
+    // True if a hierarchy has been built and no edit happened since.
+    bool hasContractionHierarchy() const;
+
     // Find shortest path from start to end using Dijkstra’s algorithm.
     // Returns true if a path is found, and outputs the path and total distance.
+    // Results are cached (see PathCacheStats); the overload below always searches.
+    bool findShortestPath(const string& start, const string& end,
+                          vector<string>& path, Weight& distance) const;
+
+    // Same as above with an explicit search strategy; stats reports the work done.
+    // AStar falls back to plain Dijkstra unless every vertex has coordinates.
     bool findShortestPath(const string& start, const string& end,
-                          vector<string>& path, int& distance) const;
+                          vector<string>& path, Weight& distance,
+                          QueryMode mode, QueryStats& stats) const;
+
+    // Result cache controls: the maximum number of cached (start, end) results,
+    // dropping everything cached, and the hit/miss/eviction counters.
+    void setPathCacheCapacity(size_t entries);
+    void clearPathCache();
+    PathCacheStats getPathCacheStats() const;
+
+    // Watched sources (e.g. "Entrance") keep a shortest-path tree that is repaired
+    // incrementally on every edge edit instead of being recomputed, so routes from them
+    // stay cheap through aisle closures. findShortestPath answers from these trees.
+    bool watchSource(const string& source);
+    bool unwatchSource(const string& source);
+
+    // Batched queries. Vertices are validated once per batch, each thread reuses its own
+    // search buffers, and independent sources run in parallel on the shared thread pool.
+    // Shortest distance from source to every reachable vertex, ordered by label.
+    bool distancesFrom(const string& source, vector<pair<string, Weight>>& distances) const;
+    // table[i][j] = shortest distance from sources[i] to targets[j], or
+    // UNREACHABLE if targets[j] is unreachable.
+    bool distanceTable(const vector<string>& sources, const vector<string>& targets,
+                       vector<vector<Weight>>& table) const;
+
+    // Plan a shopping trip from start to end that visits every vertex in 'stops'.
+    // Distances between the stops come from one Dijkstra per stop, run on several
+    // threads; the visiting order is exact (Held-Karp) for short lists and a
+    // 2-opt/Or-opt improved nearest-neighbour tour for longer ones.
+    // Outputs the stops in visiting order, the full vertex path and its length.
+    bool findShoppingRoute(const string& start, const string& end,
+                           const vector<string>& stops, vector<string>& stopOrder,
+                           vector<string>& path, Weight& distance) const;
 };
 
+// The supported weight types are compiled once in Graph.cpp
+extern template class BasicGraph<int32_t>;
+extern template class BasicGraph<int64_t>;
+extern template class BasicGraph<float>;
+extern template class BasicGraph<double>;
+
+// Graph with integer distances, as used by the store maps
+using Graph = BasicGraph<int>;
+
 #endif // GOSHOP_GRAPH_H
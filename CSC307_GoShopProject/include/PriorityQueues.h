@@ -0,0 +1,145 @@
+#ifndef GOSHOP_PRIORITYQUEUES_H
+#define GOSHOP_PRIORITYQUEUES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+using namespace std;
+
+// Monotone bucket queue (Dial's algorithm) for Dijkstra with small non-negative
+// integer edge weights. Every queued key lies in [current, current + maxEdgeWeight],
+// so maxEdgeWeight + 1 circular buckets hold each key in its own bucket and
+// push/pop are O(1) apart from skipping empty buckets. A vertex may be queued more
+// than once; callers skip entries whose key is larger than the vertex's distance.
+template <typename Key>
+class BucketQueue {
+private:
+    vector<vector<uint32_t>> buckets;
+    Key current;   // key of the bucket being drained
+    size_t count;  // queued entries
+
+public:
+    BucketQueue() : current(0), count(0) {}
+
+    // Empty the queue and size it for edges of at most maxEdgeWeight
+    void reset(Key maxEdgeWeight) {
+        size_t needed = static_cast<size_t>(maxEdgeWeight) + 1;
+        if (buckets.size() != needed) {
+            buckets.assign(needed, vector<uint32_t>());
+        } else {
+            for (auto& bucket : buckets) bucket.clear();
+        }
+        current = 0;
+        count = 0;
+    }
+
+    bool empty() const { return count == 0; }
+
+    // Queue id with the given key (key must not be below the last popped key)
+    void push(uint32_t id, Key key) {
+        buckets[static_cast<size_t>(key) % buckets.size()].push_back(id);
+        count++;
+    }
+
+    // Remove an entry with the smallest key; returns (key, id)
+    pair<Key, uint32_t> pop() {
+        size_t index = static_cast<size_t>(current) % buckets.size();
+        while (buckets[index].empty()) {
+            current++;
+            index = (index + 1 == buckets.size()) ? 0 : index + 1;
+        }
+        uint32_t id = buckets[index].back();
+        buckets[index].pop_back();
+        count--;
+        return {current, id};
+    }
+};
+
+// Indexed 4-ary min-heap over vertex ids with decrease-key, so each vertex is
+// queued at most once whatever the edge weights.
+template <typename Key>
+class IndexedHeap {
+private:
+    static constexpr uint32_t ABSENT = UINT32_MAX;
+    static constexpr size_t ARITY = 4;
+
+    vector<uint32_t> heap;  // ids in heap order
+    vector<Key> keys;       // id -> current key (valid while queued)
+    vector<uint32_t> pos;   // id -> index in heap, ABSENT if not queued
+
+    void place(size_t index, uint32_t id) {
+        heap[index] = id;
+        pos[id] = static_cast<uint32_t>(index);
+    }
+
+    void siftUp(size_t index) {
+        uint32_t id = heap[index];
+        while (index > 0) {
+            size_t parent = (index - 1) / ARITY;
+            if (!(keys[id] < keys[heap[parent]])) break;
+            place(index, heap[parent]);
+            index = parent;
+        }
+        place(index, id);
+    }
+
+    void siftDown(size_t index) {
+        uint32_t id = heap[index];
+        size_t n = heap.size();
+        while (true) {
+            size_t first = index * ARITY + 1;
+            if (first >= n) break;
+            size_t best = first;
+            size_t last = (first + ARITY < n) ? first + ARITY : n;
+            for (size_t child = first + 1; child < last; ++child) {
+                if (keys[heap[child]] < keys[heap[best]]) best = child;
+            }
+            if (!(keys[heap[best]] < keys[id])) break;
+            place(index, heap[best]);
+            index = best;
+        }
+        place(index, id);
+    }
+
+public:
+    // Empty the queue and size it for ids in [0, n)
+    void reset(size_t n) {
+        if (pos.size() != n) {
+            pos.assign(n, ABSENT);
+            keys.resize(n);
+        } else {
+            for (uint32_t id : heap) pos[id] = ABSENT;
+        }
+        heap.clear();
+    }
+
+    bool empty() const { return heap.empty(); }
+
+    // Insert id, or lower its key if it is already queued with a larger one
+    void push(uint32_t id, Key key) {
+        if (pos[id] == ABSENT) {
+            keys[id] = key;
+            heap.push_back(id);
+            siftUp(heap.size() - 1);
+        } else if (key < keys[id]) {
+            keys[id] = key;
+            siftUp(pos[id]);
+        }
+    }
+
+    // Remove the entry with the smallest key; returns (key, id)
+    pair<Key, uint32_t> pop() {
+        uint32_t id = heap.front();
+        pos[id] = ABSENT;
+        uint32_t last = heap.back();
+        heap.pop_back();
+        if (!heap.empty()) {
+            heap[0] = last;
+            siftDown(0);
+        }
+        return {keys[id], id};
+    }
+};
+
+#endif // GOSHOP_PRIORITYQUEUES_H
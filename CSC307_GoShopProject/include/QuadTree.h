@@ -4,22 +4,40 @@
 #include <iostream>
 #include <string>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <limits>
+#include <unordered_map>
+#include <vector>
 using namespace std;
 class QuadTree {
+public:
+    // One store returned by a proximity query. name points into the tree and stays
+    // valid until the next insert, remove or move.
+    struct NearbyStore {
+        const string* name;
+        double x, y;
+        double distance;  // Euclidean distance from the query point
+    };
+
 private:
-    // QuadTree node structure representing a region and possibly a store location
+    // QuadTree node structure representing a region. Internal nodes have four
+    // children; leaves hold a bucket of up to leafCapacity stores (more only at
+    // maxDepth), kept as parallel coordinate and id arrays so a leaf scan reads
+    // contiguous memory instead of chasing one node per store.
     struct QuadNode {
-        double x, y;           // coordinates of a store (if this is a leaf with a store)
-        string name;           // name of the store at this node (empty if none)
         double minX, minY;     // boundaries of this node's region (min corner)
         double maxX, maxY;     // boundaries of this node's region (max corner)
+        int depth;             // 0 for the root
         QuadNode* NW;
         QuadNode* NE;
         QuadNode* SW;
         QuadNode* SE;
-        QuadNode(double minx, double miny, double maxx, double maxy)
-            : x(0), y(0), name(""), minX(minx), minY(miny), maxX(maxx), maxY(maxy),
+        vector<double> xs;     // coordinates of the stores in this leaf
+        vector<double> ys;
+        vector<uint32_t> ids;  // store ids (index into stores), parallel to xs and ys
+        QuadNode(double minx, double miny, double maxx, double maxy, int d)
+            : minX(minx), minY(miny), maxX(maxx), maxY(maxy), depth(d),
               NW(nullptr), NE(nullptr), SW(nullptr), SE(nullptr) {}
         bool isLeaf() const {
             // A node is a leaf if it has no children.
@@ -27,25 +45,62 @@ private:
         }
     };
 
+    // A store, by id
+    struct Store {
+        string name;
+        double x, y;
+    };
+
     QuadNode* root;
     int count;  // number of stores (points) in the quadtree
+    size_t leafCapacity;  // stores a leaf holds before it splits
+    int maxDepth;         // leaves at this depth never split
+    vector<Store> stores;      // indexed by store id
+    vector<uint32_t> freeIds;  // ids of removed stores, reused first
+    unordered_map<string, uint32_t> nameIndex;  // store id of every name in the tree
 
-    // Recursive helper to insert a point into the subtree rooted at 'node'
-    bool insertNode(QuadNode* node, double x, double y, const string& name);
+    // Child quadrant of an internal node containing (x, y); points on a midline
+    // belong to the west / south side
+    static QuadNode* childFor(const QuadNode* node, double x, double y);
+    // Leaf whose region covers (x, y); path, if given, receives the nodes above it
+    QuadNode* findLeaf(double x, double y, vector<QuadNode*>* path = nullptr) const;
+    // Slot of the store at exactly (x, y) in leaf's bucket (bucket size if none)
+    static size_t slotOf(const QuadNode* leaf, double x, double y);
+    // Add store id (at its stored coordinates) to leaf, splitting the leaf if full
+    void addToLeaf(QuadNode* leaf, uint32_t id);
+    // Take the store at exactly (x, y) out of the tree, merging quadrants that
+    // became sparse; returns its id (NO_STORE if there is none)
+    uint32_t detach(double x, double y);
+    // Split a full leaf into four quadrants and spread its bucket over them
+    void splitLeaf(QuadNode* node);
+    // Fold node's children back into it if they are leaves that fit in one bucket
+    bool mergeChildren(QuadNode* node);
+    // Squared distance from (x, y) to the closest point of node's region (0 inside)
+    static double distSqToRegion(const QuadNode* node, double x, double y);
+    // Best-first traversal: report the stores within sqrt(maxDistSq) of (x, y) to
+    // visit(store id, squared distance) nearest first, until visit returns false
+    template <typename Visit>
+    void visitByDistance(double x, double y, double maxDistSq, Visit visit) const;
     // Recursive helper to find the nearest neighbor in subtree
-    void nearestNode(QuadNode* node, double targetX, double targetY,
-                     double& bestDist, QuadNode*& bestNode) const;
-    // Recursive helper to find a node by store name
-    QuadNode* findByName(QuadNode* node, const string& name) const;
+    void nearestNode(const QuadNode* node, double targetX, double targetY,
+                     double& bestDist, uint32_t& bestId) const;
     // Recursive helper to delete all nodes (used in destructor)
     void destroyNode(QuadNode* node);
 
+    // Id used when no store matches
+    static constexpr uint32_t NO_STORE = UINT32_MAX;
+
 public:
-    // Constructor: initialize QuadTree with given boundary (default boundary if not specified)
-    QuadTree(double minx = -100.0, double miny = -100.0, double maxx = 100.0, double maxy = 100.0);
+    // Constructor: initialize QuadTree with given boundary (default boundary if not
+    // specified), bucket size of a leaf and depth limit
+    QuadTree(double minx = -100.0, double miny = -100.0, double maxx = 100.0, double maxy = 100.0,
+             size_t leafCapacity = 8, int maxDepth = 24);
     // Destructor: free all nodes
     ~QuadTree();
 
+    QuadTree(const QuadTree&) = delete;
+    QuadTree& operator=(const QuadTree&) = delete;
+
     // Insert a store location with coordinates (x, y) and store name
     bool insert(double x, double y, const string& name);
 
@@ -54,12 +109,28 @@ public:
     // Remove a store by exact coordinates (returns true if removed)
     bool remove(double x, double y);
 
+    // Move a store to new coordinates (false if it does not exist, the location is
+    // out of the boundary or another store is already there)
+    bool move(const string& name, double x, double y);
+    // Look up a store's coordinates by name
+    bool findStore(const string& name, double& outX, double& outY) const;
+
     // Find the nearest store to the given (x, y) location.
     // Returns true if a store is found, and outputs the nearest store's name, coordinates, and distance.
     bool findNearest(double x, double y, string& nearestName, double& nearestX, double& nearestY, double& distance) const;
 
+    // Find the k stores closest to (x, y), nearest first. out is cleared and
+    // refilled, so reusing one buffer across queries avoids allocating per query.
+    bool findKNearest(double x, double y, size_t k, vector<NearbyStore>& out) const;
+    // Find every store within distance radius of (x, y), nearest first (same
+    // buffer contract as findKNearest). Returns false if none is in range.
+    bool findWithinRadius(double x, double y, double radius, vector<NearbyStore>& out) const;
+
     // Print all stores and their coordinates in the QuadTree
     void printLocations() const;
+
+    // Number of stores
+    int size() const { return count; }
 };
 
 #endif // GOSHOP_QUADTREE_H
@@ -1,59 +1,1365 @@
 #ifndef GOSHOP_SKIPLIST_H
 #define GOSHOP_SKIPLIST_H
 
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>  // for rand()
+#include <ctime>    // for srand()
+#include <functional>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <numeric>
+#include <optional>
+#include <set>
 #include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 #include <vector>
-#include <cstdlib>  // for rand()
-#include <ctime>    // for srand()
-#include <climits>  // for INT_MIN
 using namespace std;
+
+// True if Compare declares is_transparent (e.g. less<>), so lookups can take any
+// type the comparator accepts instead of building a Key first
+template <typename Compare, typename = void>
+struct IsTransparentCompare : false_type {};
+template <typename Compare>
+struct IsTransparentCompare<Compare, void_t<typename Compare::is_transparent>> : true_type {};
+
+// True if a T can be written to an ostream (keys are printed in error messages
+// only when it can)
+template <typename T, typename = void>
+struct IsStreamable : false_type {};
+template <typename T>
+struct IsStreamable<T, void_t<decltype(declval<ostream&>() << declval<const T&>())>>
+    : true_type {};
+
+// Ordered map from Key to Value built on a skip list, ordered by Compare. Node
+// memory comes from Alloc (rebound for the arena's slabs). The default
+// SkipList<> maps aisle numbers to their descriptions.
+template <typename Key = int, typename Value = string, typename Compare = less<Key>,
+          typename Alloc = allocator<pair<const Key, Value>>>
 class SkipList {
+public:
+    // Elements are (key, value) pairs, as in std::map
+    typedef Key key_type;
+    typedef Value mapped_type;
+    typedef pair<const Key, Value> value_type;
+    typedef Compare key_compare;
+    typedef Alloc allocator_type;
+
 private:
-    // Node structure for the Skip List
-    struct Node {
-        int key;
-        string value;
-        vector<Node*> forward; // forward pointers for each level
-        Node(int k, const string& val, int level)
-            : key(k), value(val), forward(level + 1, nullptr) {}
+    // An earlier state of an element, kept while a live snapshot can still see it:
+    // the value it had from 'stamp' until the next newer state, or no value if it
+    // was removed then. Records are chained newest first.
+    struct VersionRecord {
+        uint64_t stamp;
+        optional<Value> value;
+        VersionRecord* older;
+    };
+
+    // Node structure for the Skip List. A node is a single arena block: the header
+    // below followed by level + 1 forward pointers, so a hop touches one cache line
+    // instead of a node, a separate vector buffer and a string buffer. Short values
+    // live in the string's inline buffer inside the block; only long ones allocate.
+    // The head is a Node whose entry is never constructed, so no key value is
+    // reserved for it. A removed element that a snapshot can still see stays linked
+    // as a tombstone ('removed') until version collection unlinks it.
+    struct alignas(void*) Node {
+        int level;                 // highest level this node is linked on
+        bool removed;              // tombstone: absent from the current view
+        bool tracked;              // listed in SkipList::versioned
+        uint64_t stamp;            // version at which the current state was written
+        VersionRecord* older;      // earlier states still visible to a snapshot
+        union {
+            value_type entry;      // entry.first is the key, entry.second the value
+        };
+        // Head node: links only
+        explicit Node(int lvl)
+            : level(lvl), removed(false), tracked(false), stamp(0), older(nullptr) {}
+        // Element node: entry is built piecewise from the two argument tuples
+        template <typename KeyArgs, typename ValueArgs>
+        Node(int lvl, KeyArgs&& keyArgs, ValueArgs&& valueArgs)
+            : level(lvl), removed(false), tracked(false), stamp(0), older(nullptr),
+              entry(piecewise_construct, std::forward<KeyArgs>(keyArgs),
+                    std::forward<ValueArgs>(valueArgs)) {}
+        // entry is destroyed by destroyNode (the head has none)
+        ~Node() {}
+        // forward pointers for each level, stored right after the node
+        Node** forward() { return reinterpret_cast<Node**>(this + 1); }
+    };
+
+    // Size-class pool owning the memory of every node. Blocks are carved from large
+    // slabs; a freed block goes onto the free list of its level and is reused by the
+    // next node of that level. All slabs are released when the list is destroyed.
+    class NodeArena {
+    public:
+        explicit NodeArena(const Alloc& alloc)
+            : slabAlloc(alloc), cursor(nullptr), remaining(0) {}
+        ~NodeArena();
+        NodeArena(const NodeArena&) = delete;
+        NodeArena& operator=(const NodeArena&) = delete;
+
+        // Bytes of a node block with forward pointers for levels 0..level
+        static size_t blockSize(int level);
+        void* allocate(int level);
+        void deallocate(void* block, int level);
+
+    private:
+        // Slabs are allocated in max_align_t units so every block is aligned
+        typedef typename allocator_traits<Alloc>::template rebind_alloc<max_align_t> SlabAlloc;
+        typedef allocator_traits<SlabAlloc> SlabTraits;
+        struct FreeBlock {
+            FreeBlock* next;
+        };
+        static constexpr size_t SLAB_BYTES = 64 * 1024;
+
+        SlabAlloc slabAlloc;
+        vector<FreeBlock*> freeLists;                     // indexed by level
+        vector<pair<max_align_t*, size_t>> slabs;         // (slab, units)
+        char* cursor;                                     // unused tail of the newest slab
+        size_t remaining;
     };
+    static_assert(alignof(Node) <= alignof(max_align_t), "over-aligned keys or values");
 
-    // Maximum allowed level for nodes
-    static const int MAX_LEVEL;
+    // Hard limit on node levels; the head is allocated with this many levels so the
+    // level limit below can grow without reallocating it (2^32 elements)
+    static constexpr int LEVEL_CAP = 32;
+    // Smallest value of maxLevel, used while the list is small
+    static constexpr int MIN_MAX_LEVEL = 6;
     // Probability for level promotion (typically 0.5)
-    static const float P;
+    static constexpr float P = 0.5f;
+
+    // Type lookups compare against: the caller's own key type when Compare is
+    // transparent (e.g. a string_view among string keys), otherwise Key, so other
+    // types are converted once per call
+    template <typename K>
+    using LookupKey = conditional_t<IsTransparentCompare<Compare>::value, K, Key>;
 
     // Current highest level of any element in the skip list
     int level;
+    // Maximum level a new node may get: grows with log2 of the element count so
+    // searches stay logarithmic as the list grows (never shrinks)
+    int maxLevel;
+    // Number of elements
+    size_t count;
+    // Key ordering
+    Compare comp;
+    // Storage for head and all nodes
+    NodeArena arena;
+    // Allocator for version records
+    typename allocator_traits<Alloc>::template rebind_alloc<VersionRecord> recordAlloc;
+    // Stamp of the latest write; every insert, update and removal increments it
+    uint64_t version;
+    // Versions of the live snapshots
+    multiset<uint64_t> liveSnapshots;
+    // Nodes with version records or tombstones, revisited by collectVersions
+    vector<Node*> versioned;
     // Pointer to header (sentinel) node
     Node* head;
 
+    // Allocate a node in the arena and build its entry from the argument tuples,
+    // with null forward pointers
+    template <typename KeyArgs, typename ValueArgs>
+    Node* createNode(int lvl, KeyArgs&& keyArgs, ValueArgs&& valueArgs);
+    // Destroy an element node (and its version records) and return its block to
+    // the arena
+    void destroyNode(Node* node);
+    void destroyRecord(VersionRecord* record);
+
+    // Skip tombstones: the first element at or after node in the current view
+    static Node* firstLive(Node* node) {
+        while (node && node->removed) {
+            node = node->forward()[0];
+        }
+        return node;
+    }
+    // The node's value as of version stamp, or nullptr if it had none then
+    static const Value* visibleValue(const Node* node, uint64_t stamp);
+    // True if a live snapshot has a version in [from, to)
+    bool snapshotBetween(uint64_t from, uint64_t to) const;
+    // Before a write replaces the node's current state: move that state into a
+    // version record if a live snapshot can see it
+    void preserveState(Node* node);
+    // Add node to versioned unless it is already listed
+    void track(Node* node) {
+        if (!node->tracked) {
+            node->tracked = true;
+            versioned.push_back(node);
+        }
+    }
+    // Give an existing node (live or tombstone) a new current value
+    template <typename V>
+    void assignValue(Node* node, V&& value);
+    // Mark a live node removed from the current view, keeping its states
+    void tombstone(Node* node);
+    // Remove the live element in node, the level-0 successor of update[0]: a
+    // tombstone if a live snapshot can see one of its values, otherwise unlinked
+    void eraseNode(Node** update, Node* node);
+    // Drop version records no live snapshot can see and unlink tombstones that no
+    // snapshot needs any more
+    void collectVersions();
+    // Called when a Snapshot handle ends
+    void releaseSnapshot(uint64_t stamp);
+
+    // Append " <key>" to an error message if Key can be printed
+    static void describeKey(ostream& os, const Key& key);
+    // Hint the CPU to start loading a node (no-op where unsupported)
+    static void prefetchNode(const Node* node);
+
     // Generate a random level for a new node based on probability P
     int randomLevel() const;
+    // Descend from the top level to the last node whose key is < key (or <= key when
+    // inclusive); returns head if there is none
+    template <typename K>
+    Node* lastBefore(const K& key, bool inclusive) const;
     // Find a node by key (internal use, returns nullptr if not found)
-    Node* findNode(int key) const;
+    template <typename K>
+    Node* findNode(const K& key) const;
+    // True if node (an element, or null) holds a key equivalent to key
+    template <typename K>
+    bool holds(const Node* node, const K& key) const {
+        return node && !comp(key, node->entry.first) && !comp(node->entry.first, key);
+    }
+    // Move update[i] forward to the last node before key on every level i <= level.
+    // update[i] must already hold head or a node before key (e.g. the predecessors
+    // of a smaller key from an earlier call), so a sorted batch walks each level
+    // forward from the previous key instead of restarting at head.
+    template <typename K>
+    void seekPredecessors(Node** update, const K& key) const;
+    // Link a new node right after the predecessors in update (key must be absent)
+    template <typename KeyArgs, typename ValueArgs>
+    Node* linkNew(Node** update, KeyArgs&& keyArgs, ValueArgs&& valueArgs);
+    // Unlink and free target, the level-0 successor of update[0] (does not change
+    // count; tombstones are no longer counted)
+    void unlinkNode(Node** update, Node* target);
+    // Raise maxLevel to match the current element count
+    void growMaxLevel();
+    // bulkLoad step: link the element at 1-based position after tails[0], where
+    // tails[i] is the last node linked on level i. Fails if key is not larger than
+    // the previous key.
+    template <typename K, typename V>
+    bool appendSorted(Node** tails, size_t position, K&& key, V&& value);
+    // Positions 0..n-1 ordered by keyOf(position); stable, so equal keys keep their
+    // input order and a batch behaves like the same operations applied one by one
+    template <typename KeyOf>
+    vector<size_t> sortedPositions(size_t n, KeyOf keyOf) const;
 
 public:
+    // Forward iterator over the elements in key order (walks level 0). Elements are
+    // read-only through either kind of iterator: a value written in place would
+    // bypass the version chain and show up in live snapshots, so values change
+    // only through update, insert/emplace on a removed key, or the batch calls.
+    // Removing an element invalidates only iterators pointing at it.
+    template <bool IsConst>
+    class Iterator {
+    public:
+        typedef forward_iterator_tag iterator_category;
+        typedef SkipList::value_type value_type;
+        typedef ptrdiff_t difference_type;
+        typedef const value_type* pointer;
+        typedef const value_type& reference;
+
+        Iterator() : node(nullptr) {}
+        // iterator converts to const_iterator
+        template <bool OtherConst, typename = enable_if_t<IsConst && !OtherConst>>
+        Iterator(const Iterator<OtherConst>& other) : node(other.node) {}
+
+        reference operator*() const { return node->entry; }
+        pointer operator->() const { return &node->entry; }
+        Iterator& operator++() {
+            node = firstLive(node->forward()[0]);
+            return *this;
+        }
+        Iterator operator++(int) {
+            Iterator old = *this;
+            node = firstLive(node->forward()[0]);
+            return old;
+        }
+        friend bool operator==(const Iterator& a, const Iterator& b) { return a.node == b.node; }
+        friend bool operator!=(const Iterator& a, const Iterator& b) { return a.node != b.node; }
+
+    private:
+        friend class SkipList;
+        template <bool> friend class Iterator;
+        explicit Iterator(Node* n) : node(n) {}
+        Node* node;  // nullptr is end()
+    };
+    typedef Iterator<false> iterator;
+    typedef Iterator<true> const_iterator;
+
+    // Read-only view of the list as of the moment snapshot() was called. Later
+    // inserts, updates and removals on the list do not show up in it, so a long
+    // report can iterate a consistent state while the day's edits carry on between
+    // its steps instead of waiting for it to finish. The old states it needs are
+    // kept only as long as some snapshot can see them; ending the handle lets
+    // them be collected. A snapshot must end before its list is destroyed, and like
+    // the list itself it is not thread-safe.
+    class Snapshot {
+    public:
+        // Input iterator over the snapshot's elements in key order; dereferences
+        // to a (key, value) pair of references
+        class const_iterator {
+        public:
+            typedef input_iterator_tag iterator_category;
+            typedef pair<const Key&, const Value&> value_type;
+            typedef ptrdiff_t difference_type;
+            typedef value_type reference;
+            struct pointer {
+                value_type entry;
+                const value_type* operator->() const { return &entry; }
+            };
+
+            const_iterator() : node(nullptr), value(nullptr), stamp(0) {}
+            reference operator*() const { return {node->entry.first, *value}; }
+            pointer operator->() const { return {**this}; }
+            const_iterator& operator++() {
+                node = node->forward()[0];
+                settle();
+                return *this;
+            }
+            const_iterator operator++(int) {
+                const_iterator old = *this;
+                ++*this;
+                return old;
+            }
+            friend bool operator==(const const_iterator& a, const const_iterator& b) {
+                return a.node == b.node;
+            }
+            friend bool operator!=(const const_iterator& a, const const_iterator& b) {
+                return a.node != b.node;
+            }
+
+        private:
+            friend class Snapshot;
+            const_iterator(Node* n, uint64_t s) : node(n), value(nullptr), stamp(s) { settle(); }
+            // Move to the first node at or after node that had a value at stamp
+            void settle() {
+                while (node && (value = visibleValue(node, stamp)) == nullptr) {
+                    node = node->forward()[0];
+                }
+            }
+            Node* node;           // nullptr is end()
+            const Value* value;   // node's value as of stamp
+            uint64_t stamp;
+        };
+
+        Snapshot() : list(nullptr), stamp(0), elements(0) {}
+        Snapshot(Snapshot&& other) noexcept
+            : list(other.list), stamp(other.stamp), elements(other.elements) {
+            other.list = nullptr;
+        }
+        Snapshot& operator=(Snapshot&& other) noexcept {
+            if (this != &other) {
+                release();
+                list = other.list;
+                stamp = other.stamp;
+                elements = other.elements;
+                other.list = nullptr;
+            }
+            return *this;
+        }
+        Snapshot(const Snapshot&) = delete;
+        Snapshot& operator=(const Snapshot&) = delete;
+        ~Snapshot() { release(); }
+
+        // End the snapshot early (the handle is then empty)
+        void release() {
+            if (list) {
+                list->releaseSnapshot(stamp);
+                list = nullptr;
+            }
+        }
+
+        // List version the snapshot shows
+        uint64_t version() const { return stamp; }
+        // Number of elements at that version
+        size_t size() const { return elements; }
+        bool empty() const { return elements == 0; }
+
+        // Search for a key, output its value at the snapshot's version if found
+        template <typename K = Key>
+        bool search(const K& key, Value& outValue) const;
+        template <typename K = Key>
+        bool contains(const K& key) const;
+
+        const_iterator begin() const { return const_iterator(list->head->forward()[0], stamp); }
+        const_iterator end() const { return const_iterator(); }
+        // First element with key >= key (end() if none)
+        template <typename K = Key>
+        const_iterator lower_bound(const K& key) const;
+
+        // Call callback(key, value) for every key in [lo, hi] at the snapshot's
+        // version; returns the number of elements visited
+        template <typename K = Key>
+        size_t rangeQuery(const K& lo, const K& hi,
+                          const function<void(const Key&, const Value&)>& callback) const;
+
+    private:
+        friend class SkipList;
+        Snapshot(SkipList* l, uint64_t s, size_t n) : list(l), stamp(s), elements(n) {}
+        // The node holding key (possibly a tombstone), or nullptr
+        template <typename K>
+        Node* locate(const K& key) const;
+
+        SkipList* list;
+        uint64_t stamp;
+        size_t elements;
+    };
+
     // Constructor: initialize skip list
-    SkipList();
+    SkipList() : SkipList(Compare()) {}
+    explicit SkipList(const Compare& compare, const Alloc& alloc = Alloc());
     // Destructor: free all nodes
     ~SkipList();
 
-    // Insert a key-value pair into the skip list (returns false if key exists)
-    bool insert(int key, const string& value);
+    // Nodes belong to the list's arena, so lists are not copyable
+    SkipList(const SkipList&) = delete;
+    SkipList& operator=(const SkipList&) = delete;
+
+    // Insert a key-value pair into the skip list (returns false if key exists).
+    // Arguments passed as rvalues are moved into the node, not copied.
+    bool insert(Key key, Value value);
+
+    // Build the value in place from args if key is absent (like map::try_emplace);
+    // returns the element with that key and whether it was inserted
+    template <typename... Args>
+    pair<iterator, bool> emplace(Key key, Args&&... args);
+
+    // Lookups below accept any key type K: with a transparent Compare it is compared
+    // as is, otherwise it is converted to Key first.
 
     // Search for a key, output value in outValue if found
-    bool search(int key, string &outValue) const;
+    template <typename K = Key>
+    bool search(const K& key, Value& outValue) const;
+
+    // Element with the given key (end() if none)
+    template <typename K = Key>
+    iterator find(const K& key);
+    template <typename K = Key>
+    const_iterator find(const K& key) const;
+    template <typename K = Key>
+    bool contains(const K& key) const { return find(key) != end(); }
 
     // Update the value for an existing key
-    bool update(int key, const string& newValue);
+    template <typename K = Key>
+    bool update(const K& key, Value newValue);
 
     // Remove a key-value pair from the skip list
-    bool remove(int key);
+    template <typename K = Key>
+    bool remove(const K& key);
 
     // Display all elements (key and value) in the skip list (level 0 list)
     void displayList() const;
+
+    // Consistent read-only view of the current contents (see Snapshot)
+    Snapshot snapshot();
+    // Number of live snapshots
+    size_t snapshotCount() const { return liveSnapshots.size(); }
+
+    // Batch versions of insert/update/remove for feeds of many keys. The batch is
+    // sorted by key and one predecessor "finger" is carried from key to key, so
+    // each operation walks forward from the previous position instead of starting
+    // at head. Results match applying the items one by one in input order (for a
+    // repeated key the first insert and the last update win). Failures are reported
+    // in a single summary line; each returns the number of items applied. Values of
+    // a batch passed with std::move are moved into the list.
+    size_t insertBatch(vector<pair<Key, Value>> items);
+    size_t updateBatch(vector<pair<Key, Value>> items);
+    size_t removeBatch(const vector<Key>& keys);
+
+    // Look up many keys at once: several descents run interleaved, each prefetching
+    // the next node it will visit, so their cache misses overlap. outValues[i] and
+    // found[i] describe keys[i]; returns the number of keys found.
+    size_t searchBatch(const vector<Key>& keys, vector<Value>& outValues,
+                       vector<bool>& found) const;
+
+    // Number of elements
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    // Remove all elements (while snapshots are live they keep seeing them)
+    void clear();
+
+    // Replace the contents with the (key, value) pairs of [first, last), which must
+    // be sorted by strictly increasing key (e.g. a catalog snapshot). Runs in O(n)
+    // and builds a perfectly balanced level structure: the i-th element gets as many
+    // levels as i has trailing zero bits, so every 2^k-th element reaches level k.
+    // Elements are moved in from a move_iterator range. Returns false (leaving the
+    // list empty) if the keys are out of order, and fails without changes while a
+    // snapshot is live.
+    template <typename InputIt>
+    bool bulkLoad(InputIt first, InputIt last);
+
+    // Iteration in key order
+    iterator begin() { return iterator(firstLive(head->forward()[0])); }
+    iterator end() { return iterator(); }
+    const_iterator begin() const { return const_iterator(firstLive(head->forward()[0])); }
+    const_iterator end() const { return const_iterator(); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    // First element with key >= key (end() if none)
+    template <typename K = Key>
+    iterator lower_bound(const K& key);
+    template <typename K = Key>
+    const_iterator lower_bound(const K& key) const;
+    // First element with key > key (end() if none)
+    template <typename K = Key>
+    iterator upper_bound(const K& key);
+    template <typename K = Key>
+    const_iterator upper_bound(const K& key) const;
+    // Element with the largest key <= key, e.g. the nearest aisle at or below key
+    // (end() if none)
+    template <typename K = Key>
+    iterator floor(const K& key);
+    template <typename K = Key>
+    const_iterator floor(const K& key) const;
+    // Element with the smallest key >= key (end() if none); same as lower_bound
+    template <typename K = Key>
+    iterator ceiling(const K& key) { return lower_bound(key); }
+    template <typename K = Key>
+    const_iterator ceiling(const K& key) const { return lower_bound(key); }
+
+    // Call callback(key, value) for every key in [lo, hi] in ascending order. The
+    // list is descended once to lo, then level 0 is streamed; values are passed by
+    // reference, not copied. The callback must not modify the list. Returns the
+    // number of elements visited.
+    template <typename K = Key>
+    size_t rangeQuery(const K& lo, const K& hi,
+                      const function<void(const Key&, const Value&)>& callback) const;
 };
 
+// SkipList Implementation: Random level skip list for quick search/insert
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+SkipList<Key, Value, Compare, Alloc>::NodeArena::~NodeArena() {
+    for (auto& slab : slabs) {
+        SlabTraits::deallocate(slabAlloc, slab.first, slab.second);
+    }
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+size_t SkipList<Key, Value, Compare, Alloc>::NodeArena::blockSize(int level) {
+    size_t bytes = sizeof(Node) + (level + 1) * sizeof(Node*);
+    // Keep every block aligned for the next one carved from the same slab
+    return (bytes + alignof(Node) - 1) / alignof(Node) * alignof(Node);
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+void* SkipList<Key, Value, Compare, Alloc>::NodeArena::allocate(int level) {
+    if (static_cast<size_t>(level) < freeLists.size() && freeLists[level] != nullptr) {
+        FreeBlock* block = freeLists[level];
+        freeLists[level] = block->next;
+        return block;
+    }
+    size_t bytes = blockSize(level);
+    if (bytes > remaining) {
+        // Start a new slab; the old slab's tail is too small and stays unused
+        size_t units = (max(SLAB_BYTES, bytes) + sizeof(max_align_t) - 1) / sizeof(max_align_t);
+        max_align_t* slab = SlabTraits::allocate(slabAlloc, units);
+        slabs.emplace_back(slab, units);
+        cursor = reinterpret_cast<char*>(slab);
+        remaining = units * sizeof(max_align_t);
+    }
+    void* block = cursor;
+    cursor += bytes;
+    remaining -= bytes;
+    return block;
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+void SkipList<Key, Value, Compare, Alloc>::NodeArena::deallocate(void* block, int level) {
+    if (static_cast<size_t>(level) >= freeLists.size()) {
+        freeLists.resize(level + 1, nullptr);
+    }
+    FreeBlock* freed = static_cast<FreeBlock*>(block);
+    freed->next = freeLists[level];
+    freeLists[level] = freed;
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+template <typename KeyArgs, typename ValueArgs>
+auto SkipList<Key, Value, Compare, Alloc>::createNode(int lvl, KeyArgs&& keyArgs,
+                                                      ValueArgs&& valueArgs) -> Node* {
+    void* block = arena.allocate(lvl);
+    Node* node;
+    try {
+        node = new (block) Node(lvl, std::forward<KeyArgs>(keyArgs),
+                                std::forward<ValueArgs>(valueArgs));
+    } catch (...) {
+        arena.deallocate(block, lvl);
+        throw;
+    }
+    Node** links = node->forward();
+    for (int i = 0; i <= lvl; ++i) {
+        links[i] = nullptr;
+    }
+    return node;
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+void SkipList<Key, Value, Compare, Alloc>::destroyRecord(VersionRecord* record) {
+    typedef allocator_traits<decltype(recordAlloc)> RecordTraits;
+    RecordTraits::destroy(recordAlloc, record);
+    RecordTraits::deallocate(recordAlloc, record, 1);
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+void SkipList<Key, Value, Compare, Alloc>::destroyNode(Node* node) {
+    while (node->older) {
+        VersionRecord* record = node->older;
+        node->older = record->older;
+        destroyRecord(record);
+    }
+    int lvl = node->level;
+    destroy_at(&node->entry);
+    node->~Node();
+    arena.deallocate(node, lvl);
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+void SkipList<Key, Value, Compare, Alloc>::describeKey(ostream& os, const Key& key) {
+    if constexpr (IsStreamable<Key>::value) {
+        os << " " << key;
+    }
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+void SkipList<Key, Value, Compare, Alloc>::prefetchNode(const Node* node) {
+    // Prefetching a null pointer is harmless
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(node);
+#else
+    (void)node;
+#endif
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+SkipList<Key, Value, Compare, Alloc>::SkipList(const Compare& compare, const Alloc& alloc)
+    : level(0), maxLevel(MIN_MAX_LEVEL), count(0), comp(compare), arena(alloc),
+      recordAlloc(alloc), version(0) {
+    // Initialize random seed for random level generation
+    srand(static_cast<unsigned>(time(nullptr)));
+    // Create the header node with every level (forward pointers start out null)
+    head = new (arena.allocate(LEVEL_CAP)) Node(LEVEL_CAP);
+    for (int i = 0; i <= LEVEL_CAP; ++i) {
+        head->forward()[i] = nullptr;
+    }
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+SkipList<Key, Value, Compare, Alloc>::~SkipList() {
+    // Delete all nodes, tombstones included; the arena then releases its slabs,
+    // head included
+    liveSnapshots.clear();
+    clear();
+    head->~Node();
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+int SkipList<Key, Value, Compare, Alloc>::randomLevel() const {
+    int lvl = 0;
+    // Increase level with probability P for each level
+    while (((double) rand() / RAND_MAX) < P && lvl < maxLevel) {
+        lvl++;
+    }
+    return lvl;
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+template <typename K>
+auto SkipList<Key, Value, Compare, Alloc>::lastBefore(const K& key, bool inclusive) const
+    -> Node* {
+    Node* current = head;
+    // Start from highest level and move down levels
+    for (int i = level; i >= 0; --i) {
+        Node* next;
+        while ((next = current->forward()[i]) != nullptr &&
+               (comp(next->entry.first, key) || (inclusive && !comp(key, next->entry.first)))) {
+            current = next;
+        }
+    }
+    return current;
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+template <typename K>
+auto SkipList<Key, Value, Compare, Alloc>::findNode(const K& key) const -> Node* {
+    // Move to the next node at level 0 (possibly the target)
+    Node* current = lastBefore(key, false)->forward()[0];
+    return holds(current, key) && !current->removed ? current : nullptr;
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+void SkipList<Key, Value, Compare, Alloc>::growMaxLevel() {
+    // log2(count) levels give an expected O(1) nodes per level with P = 0.5
+    int wanted = static_cast<int>(bit_width(count)) - 1;
+    if (wanted > maxLevel) {
+        maxLevel = min(wanted, LEVEL_CAP);
+    }
+}
+
+// Search for key in SkipList
+template <typename Key, typename Value, typename Compare, typename Alloc>
+template <typename K>
+bool SkipList<Key, Value, Compare, Alloc>::search(const K& key, Value& outValue) const {
+    const LookupKey<K>& lookup = key;
+    Node* node = findNode(lookup);
+    if (node) {
+        outValue = node->entry.second;
+        return true;
+    }
+    return false;
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+template <typename K>
+auto SkipList<Key, Value, Compare, Alloc>::find(const K& key) -> iterator {
+    const LookupKey<K>& lookup = key;
+    return iterator(findNode(lookup));
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+template <typename K>
+auto SkipList<Key, Value, Compare, Alloc>::find(const K& key) const -> const_iterator {
+    const LookupKey<K>& lookup = key;
+    return const_iterator(findNode(lookup));
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+template <typename K>
+void SkipList<Key, Value, Compare, Alloc>::seekPredecessors(Node** update, const K& key) const {
+    Node* current = head;
+    // Start from highest level and move down levels
+    for (int i = level; i >= 0; --i) {
+        // Resume from the finger on this level if it is further along than the node
+        // reached on the level above
+        Node* finger = update[i];
+        if (finger != head &&
+            (current == head || comp(current->entry.first, finger->entry.first))) {
+            current = finger;
+        }
+        while (current->forward()[i] && comp(current->forward()[i]->entry.first, key)) {
+            current = current->forward()[i];
+        }
+        update[i] = current;
+    }
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+template <typename KeyArgs, typename ValueArgs>
+auto SkipList<Key, Value, Compare, Alloc>::linkNew(Node** update, KeyArgs&& keyArgs,
+                                                   ValueArgs&& valueArgs) -> Node* {
+    // Generate random level for the new node
+    int newLevel = randomLevel();
+    // Create the new node
+    Node* newNode = createNode(newLevel, std::forward<KeyArgs>(keyArgs),
+                               std::forward<ValueArgs>(valueArgs));
+    if (newLevel > level) {
+        // If new node's level is higher, update header forward pointers for levels in between
+        for (int i = level + 1; i <= newLevel; ++i) {
+            update[i] = head;
+        }
+        level = newLevel;
+    }
+    // Insert the new node by adjusting forward pointers at each level
+    for (int i = 0; i <= newLevel; ++i) {
+        newNode->forward()[i] = update[i]->forward()[i];
+        update[i]->forward()[i] = newNode;
+    }
+    newNode->stamp = ++version;
+    count++;
+    growMaxLevel();
+    return newNode;
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+void SkipList<Key, Value, Compare, Alloc>::unlinkNode(Node** update, Node* target) {
+    // Adjust pointers at each level to bypass the node being removed
+    for (int i = 0; i <= level; ++i) {
+        if (update[i]->forward()[i] != target) break;
+        update[i]->forward()[i] = target->forward()[i];
+    }
+    // Return the node's block to the arena
+    destroyNode(target);
+    // Reduce level if the highest level is now empty
+    while (level > 0 && head->forward()[level] == nullptr) {
+        level--;
+    }
+}
+
+// Insert key and value into SkipList
+template <typename Key, typename Value, typename Compare, typename Alloc>
+bool SkipList<Key, Value, Compare, Alloc>::insert(Key key, Value value) {
+    // Track nodes that need to update their forward pointers (update path)
+    Node* update[LEVEL_CAP + 1];
+    fill(update, update + level + 1, head);
+    // Find position for insertion on each level
+    seekPredecessors(update, key);
+    Node* current = update[0]->forward()[0];
+    if (holds(current, key) && current->removed) {
+        // A tombstone kept for a snapshot comes back to life
+        assignValue(current, std::move(value));
+        return true;
+    }
+    // If key already exists, do not insert (or optionally update)
+    if (holds(current, key)) {
+        cerr << "SkipList: Key";
+        describeKey(cerr, key);
+        cerr << " already exists.\n";
+        return false;
+    }
+    linkNew(update, forward_as_tuple(std::move(key)), forward_as_tuple(std::move(value)));
+    return true;
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+template <typename... Args>
+auto SkipList<Key, Value, Compare, Alloc>::emplace(Key key, Args&&... args)
+    -> pair<iterator, bool> {
+    Node* update[LEVEL_CAP + 1];
+    fill(update, update + level + 1, head);
+    seekPredecessors(update, key);
+    Node* current = update[0]->forward()[0];
+    if (holds(current, key) && current->removed) {
+        assignValue(current, Value(std::forward<Args>(args)...));
+        return {iterator(current), true};
+    }
+    if (holds(current, key)) {
+        return {iterator(current), false};
+    }
+    Node* newNode = linkNew(update, forward_as_tuple(std::move(key)),
+                            forward_as_tuple(std::forward<Args>(args)...));
+    return {iterator(newNode), true};
+}
+
+// Update value for existing key in SkipList
+template <typename Key, typename Value, typename Compare, typename Alloc>
+template <typename K>
+bool SkipList<Key, Value, Compare, Alloc>::update(const K& key, Value newValue) {
+    const LookupKey<K>& lookup = key;
+    Node* node = findNode(lookup);
+    if (node) {
+        assignValue(node, std::move(newValue));
+        return true;
+    }
+    cerr << "SkipList: Key";
+    if constexpr (IsStreamable<K>::value) {
+        cerr << " " << key;
+    }
+    cerr << " not found for update.\n";
+    return false;
+}
+
+// Remove key from SkipList
+template <typename Key, typename Value, typename Compare, typename Alloc>
+template <typename K>
+bool SkipList<Key, Value, Compare, Alloc>::remove(const K& key) {
+    const LookupKey<K>& lookup = key;
+    Node* update[LEVEL_CAP + 1];
+    fill(update, update + level + 1, head);
+    // Find the node and keep track of nodes at each level that point to it
+    seekPredecessors(update, lookup);
+    Node* current = update[0]->forward()[0];
+    // If target key is not present
+    if (!holds(current, lookup) || current->removed) {
+        cerr << "SkipList: Key";
+        if constexpr (IsStreamable<K>::value) {
+            cerr << " " << key;
+        }
+        cerr << " not found for deletion.\n";
+        return false;
+    }
+    eraseNode(update, current);
+    return true;
+}
+
+// Display all key-value pairs in SkipList
+template <typename Key, typename Value, typename Compare, typename Alloc>
+void SkipList<Key, Value, Compare, Alloc>::displayList() const {
+    cout << "SkipList contents (level 0):\n";
+    for (Node* node = firstLive(head->forward()[0]); node != nullptr;
+         node = firstLive(node->forward()[0])) {
+        cout << "  Aisle " << node->entry.first << " -> " << node->entry.second << "\n";
+    }
+}
+
+// Remove all elements, keeping the head
+template <typename Key, typename Value, typename Compare, typename Alloc>
+void SkipList<Key, Value, Compare, Alloc>::clear() {
+    if (!liveSnapshots.empty()) {
+        // Snapshots still see the elements: turn them into tombstones instead
+        for (Node* node = firstLive(head->forward()[0]); node != nullptr;
+             node = firstLive(node->forward()[0])) {
+            tombstone(node);
+        }
+        return;
+    }
+    versioned.clear();
+    Node* current = head->forward()[0];
+    while (current != nullptr) {
+        Node* next = current->forward()[0];
+        destroyNode(current);
+        current = next;
+    }
+    for (int i = 0; i <= LEVEL_CAP; ++i) {
+        head->forward()[i] = nullptr;
+    }
+    level = 0;
+    count = 0;
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+template <typename InputIt>
+bool SkipList<Key, Value, Compare, Alloc>::bulkLoad(InputIt first, InputIt last) {
+    if (!liveSnapshots.empty()) {
+        cerr << "SkipList: cannot bulk load while a snapshot is live.\n";
+        return false;
+    }
+    clear();
+    Node* tails[LEVEL_CAP + 1];
+    for (Node*& tail : tails) {
+        tail = head;
+    }
+    size_t position = 0;
+    for (; first != last; ++first) {
+        // Rvalue elements (from a move_iterator) have their key and value moved
+        auto&& item = *first;
+        if (!appendSorted(tails, ++position, std::forward<decltype(item)>(item).first,
+                          std::forward<decltype(item)>(item).second)) {
+            clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+template <typename K, typename V>
+bool SkipList<Key, Value, Compare, Alloc>::appendSorted(Node** tails, size_t position,
+                                                        K&& key, V&& value) {
+    if (tails[0] != head && !comp(tails[0]->entry.first, key)) {
+        cerr << "SkipList: bulk load keys are not sorted";
+        if constexpr (IsStreamable<Key>::value) {
+            cerr << " (" << key << " after " << tails[0]->entry.first << ")";
+        }
+        cerr << ".\n";
+        return false;
+    }
+    // Position-based level: every 2^k-th element is linked on levels 0..k
+    int newLevel = min(countr_zero(position), LEVEL_CAP);
+    Node* newNode = createNode(newLevel, forward_as_tuple(std::forward<K>(key)),
+                               forward_as_tuple(std::forward<V>(value)));
+    for (int i = 0; i <= newLevel; ++i) {
+        tails[i]->forward()[i] = newNode;
+        tails[i] = newNode;
+    }
+    newNode->stamp = ++version;
+    level = max(level, newLevel);
+    count++;
+    growMaxLevel();
+    return true;
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+template <typename KeyOf>
+vector<size_t> SkipList<Key, Value, Compare, Alloc>::sortedPositions(size_t n,
+                                                                     KeyOf keyOf) const {
+    vector<size_t> positions(n);
+    iota(positions.begin(), positions.end(), 0);
+    stable_sort(positions.begin(), positions.end(),
+                [&](size_t a, size_t b) { return comp(keyOf(a), keyOf(b)); });
+    return positions;
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+size_t SkipList<Key, Value, Compare, Alloc>::insertBatch(vector<pair<Key, Value>> items) {
+    // The finger starts at head; each key then only walks forward from the last one
+    Node* update[LEVEL_CAP + 1];
+    fill(update, update + LEVEL_CAP + 1, head);
+    size_t inserted = 0;
+    auto keyOf = [&](size_t i) -> const Key& { return items[i].first; };
+    for (size_t position : sortedPositions(items.size(), keyOf)) {
+        pair<Key, Value>& item = items[position];
+        seekPredecessors(update, item.first);
+        Node* current = update[0]->forward()[0];
+        if (holds(current, item.first)) {
+            if (!current->removed) continue;
+            assignValue(current, std::move(item.second));
+        } else {
+            linkNew(update, forward_as_tuple(std::move(item.first)),
+                    forward_as_tuple(std::move(item.second)));
+        }
+        inserted++;
+    }
+    if (inserted < items.size()) {
+        cerr << "SkipList: " << items.size() - inserted << " of " << items.size()
+             << " batch inserts skipped (key already exists).\n";
+    }
+    return inserted;
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+size_t SkipList<Key, Value, Compare, Alloc>::updateBatch(vector<pair<Key, Value>> items) {
+    Node* update[LEVEL_CAP + 1];
+    fill(update, update + LEVEL_CAP + 1, head);
+    size_t updated = 0;
+    auto keyOf = [&](size_t i) -> const Key& { return items[i].first; };
+    for (size_t position : sortedPositions(items.size(), keyOf)) {
+        pair<Key, Value>& item = items[position];
+        seekPredecessors(update, item.first);
+        Node* current = update[0]->forward()[0];
+        if (!holds(current, item.first) || current->removed) continue;
+        assignValue(current, std::move(item.second));
+        updated++;
+    }
+    if (updated < items.size()) {
+        cerr << "SkipList: " << items.size() - updated << " of " << items.size()
+             << " batch updates skipped (key not found).\n";
+    }
+    return updated;
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+size_t SkipList<Key, Value, Compare, Alloc>::removeBatch(const vector<Key>& keys) {
+    Node* update[LEVEL_CAP + 1];
+    fill(update, update + LEVEL_CAP + 1, head);
+    size_t removed = 0;
+    for (size_t position : sortedPositions(keys.size(),
+                                           [&](size_t i) -> const Key& { return keys[i]; })) {
+        // The finger holds predecessors, never the removed node, so it stays valid
+        seekPredecessors(update, keys[position]);
+        Node* current = update[0]->forward()[0];
+        if (!holds(current, keys[position]) || current->removed) continue;
+        eraseNode(update, current);
+        removed++;
+    }
+    if (removed < keys.size()) {
+        cerr << "SkipList: " << keys.size() - removed << " of " << keys.size()
+             << " batch removals skipped (key not found).\n";
+    }
+    return removed;
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+size_t SkipList<Key, Value, Compare, Alloc>::searchBatch(const vector<Key>& keys,
+                                                         vector<Value>& outValues,
+                                                         vector<bool>& found) const {
+    outValues.assign(keys.size(), Value());
+    found.assign(keys.size(), false);
+
+    // One in-flight descent: 'candidate' is the next node to compare against and
+    // was prefetched when it was chosen, so by the time this lookup's turn comes
+    // round again its cache line has (ideally) arrived
+    struct Lookup {
+        size_t index;     // position in keys
+        Node* current;    // last node known to be before the key
+        Node* candidate;  // current->forward()[lvl]
+        int lvl;
+    };
+    const size_t GROUP = 8;  // descents interleaved to overlap their cache misses
+    Lookup lookups[GROUP];
+    size_t active = 0;
+    size_t nextKey = 0;
+    size_t hits = 0;
+
+    auto start = [&](Lookup& lookup, size_t index) {
+        lookup.index = index;
+        lookup.current = head;
+        lookup.lvl = level;
+        lookup.candidate = head->forward()[level];
+        prefetchNode(lookup.candidate);
+    };
+    while (active < GROUP && nextKey < keys.size()) {
+        start(lookups[active++], nextKey++);
+    }
+
+    // Round-robin: each lookup takes one step per round
+    while (active > 0) {
+        for (size_t j = 0; j < active;) {
+            Lookup& lookup = lookups[j];
+            const Key& key = keys[lookup.index];
+            if (lookup.candidate && comp(lookup.candidate->entry.first, key)) {
+                lookup.current = lookup.candidate;
+            } else if (lookup.lvl > 0) {
+                lookup.lvl--;
+            } else {
+                // Level 0 reached: the candidate is the first node >= key
+                if (holds(lookup.candidate, key) && !lookup.candidate->removed) {
+                    outValues[lookup.index] = lookup.candidate->entry.second;
+                    found[lookup.index] = true;
+                    hits++;
+                }
+                if (nextKey < keys.size()) {
+                    start(lookup, nextKey++);
+                    j++;
+                } else {
+                    // Retire this slot; the moved-in lookup is stepped next
+                    lookup = lookups[--active];
+                }
+                continue;
+            }
+            lookup.candidate = lookup.current->forward()[lookup.lvl];
+            prefetchNode(lookup.candidate);
+            j++;
+        }
+    }
+    return hits;
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+template <typename K>
+auto SkipList<Key, Value, Compare, Alloc>::lower_bound(const K& key) -> iterator {
+    const LookupKey<K>& lookup = key;
+    return iterator(firstLive(lastBefore(lookup, false)->forward()[0]));
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+template <typename K>
+auto SkipList<Key, Value, Compare, Alloc>::lower_bound(const K& key) const -> const_iterator {
+    const LookupKey<K>& lookup = key;
+    return const_iterator(firstLive(lastBefore(lookup, false)->forward()[0]));
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+template <typename K>
+auto SkipList<Key, Value, Compare, Alloc>::upper_bound(const K& key) -> iterator {
+    const LookupKey<K>& lookup = key;
+    return iterator(firstLive(lastBefore(lookup, true)->forward()[0]));
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+template <typename K>
+auto SkipList<Key, Value, Compare, Alloc>::upper_bound(const K& key) const -> const_iterator {
+    const LookupKey<K>& lookup = key;
+    return const_iterator(firstLive(lastBefore(lookup, true)->forward()[0]));
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+template <typename K>
+auto SkipList<Key, Value, Compare, Alloc>::floor(const K& key) -> iterator {
+    const LookupKey<K>& lookup = key;
+    Node* node = lastBefore(lookup, true);
+    // Step back over tombstones (only present while snapshots are live)
+    while (node != head && node->removed) {
+        node = lastBefore(node->entry.first, false);
+    }
+    return iterator(node == head ? nullptr : node);
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+template <typename K>
+auto SkipList<Key, Value, Compare, Alloc>::floor(const K& key) const -> const_iterator {
+    const LookupKey<K>& lookup = key;
+    Node* node = lastBefore(lookup, true);
+    while (node != head && node->removed) {
+        node = lastBefore(node->entry.first, false);
+    }
+    return const_iterator(node == head ? nullptr : node);
+}
+
+// Visit every key in [lo, hi]: one descent, then a level-0 walk
+template <typename Key, typename Value, typename Compare, typename Alloc>
+template <typename K>
+size_t SkipList<Key, Value, Compare, Alloc>::rangeQuery(
+    const K& lo, const K& hi, const function<void(const Key&, const Value&)>& callback) const {
+    const LookupKey<K>& first = lo;
+    const LookupKey<K>& last = hi;
+    size_t visited = 0;
+    for (Node* node = lastBefore(first, false)->forward()[0];
+         node != nullptr && !comp(last, node->entry.first); node = node->forward()[0]) {
+        if (node->removed) continue;
+        callback(node->entry.first, node->entry.second);
+        visited++;
+    }
+    return visited;
+}
+
+// ---- Versions and snapshots
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+auto SkipList<Key, Value, Compare, Alloc>::visibleValue(const Node* node, uint64_t stamp)
+    -> const Value* {
+    if (node->stamp <= stamp) {
+        return node->removed ? nullptr : &node->entry.second;
+    }
+    // The current state is newer than the snapshot: find the state it saw
+    for (const VersionRecord* record = node->older; record != nullptr; record = record->older) {
+        if (record->stamp <= stamp) {
+            return record->value ? &*record->value : nullptr;
+        }
+    }
+    // The element did not exist yet
+    return nullptr;
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+bool SkipList<Key, Value, Compare, Alloc>::snapshotBetween(uint64_t from, uint64_t to) const {
+    auto it = liveSnapshots.lower_bound(from);
+    return it != liveSnapshots.end() && *it < to;
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+void SkipList<Key, Value, Compare, Alloc>::preserveState(Node* node) {
+    // Snapshots taken after the current state was written can see it
+    if (liveSnapshots.empty() || *liveSnapshots.rbegin() < node->stamp) return;
+    typedef allocator_traits<decltype(recordAlloc)> RecordTraits;
+    VersionRecord* record = RecordTraits::allocate(recordAlloc, 1);
+    try {
+        RecordTraits::construct(recordAlloc, record,
+                                VersionRecord{node->stamp, nullopt, node->older});
+        if (!node->removed) {
+            record->value.emplace(std::move(node->entry.second));
+        }
+    } catch (...) {
+        RecordTraits::deallocate(recordAlloc, record, 1);
+        throw;
+    }
+    node->older = record;
+    track(node);
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+template <typename V>
+void SkipList<Key, Value, Compare, Alloc>::assignValue(Node* node, V&& value) {
+    preserveState(node);
+    node->entry.second = std::forward<V>(value);
+    if (node->removed) {
+        node->removed = false;
+        count++;
+    }
+    node->stamp = ++version;
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+void SkipList<Key, Value, Compare, Alloc>::tombstone(Node* node) {
+    preserveState(node);
+    track(node);
+    node->removed = true;
+    node->stamp = ++version;
+    count--;
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+void SkipList<Key, Value, Compare, Alloc>::eraseNode(Node** update, Node* node) {
+    // Oldest state still recorded; a snapshot at least this new may see a value.
+    // Tracked nodes are always left to collectVersions so versioned never holds
+    // a freed node.
+    uint64_t oldest = node->stamp;
+    for (VersionRecord* record = node->older; record != nullptr; record = record->older) {
+        oldest = record->stamp;
+    }
+    if (node->tracked || (!liveSnapshots.empty() && *liveSnapshots.rbegin() >= oldest)) {
+        tombstone(node);
+        return;
+    }
+    count--;
+    version++;
+    unlinkNode(update, node);
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+void SkipList<Key, Value, Compare, Alloc>::collectVersions() {
+    vector<Node*> kept;
+    for (Node* node : versioned) {
+        // State i is visible to snapshots in [its stamp, the next newer stamp)
+        uint64_t newer = node->stamp;
+        bool valueVisible = !node->removed && snapshotBetween(node->stamp, UINT64_MAX);
+        VersionRecord** link = &node->older;
+        while (*link != nullptr) {
+            VersionRecord* record = *link;
+            bool visible = snapshotBetween(record->stamp, newer);
+            newer = record->stamp;
+            if (visible) {
+                valueVisible = valueVisible || record->value.has_value();
+                link = &record->older;
+            } else {
+                *link = record->older;
+                destroyRecord(record);
+            }
+        }
+        if (node->removed && !valueVisible) {
+            // No snapshot can see this element any more: unlink the tombstone
+            Node* update[LEVEL_CAP + 1];
+            fill(update, update + level + 1, head);
+            seekPredecessors(update, node->entry.first);
+            unlinkNode(update, node);
+        } else if (node->removed || node->older) {
+            kept.push_back(node);
+        } else {
+            node->tracked = false;
+        }
+    }
+    versioned.swap(kept);
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+void SkipList<Key, Value, Compare, Alloc>::releaseSnapshot(uint64_t stamp) {
+    liveSnapshots.erase(liveSnapshots.find(stamp));
+    if (!versioned.empty()) {
+        collectVersions();
+    }
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+auto SkipList<Key, Value, Compare, Alloc>::snapshot() -> Snapshot {
+    liveSnapshots.insert(version);
+    return Snapshot(this, version, count);
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+template <typename K>
+auto SkipList<Key, Value, Compare, Alloc>::Snapshot::locate(const K& key) const -> Node* {
+    const LookupKey<K>& lookup = key;
+    Node* node = list->lastBefore(lookup, false)->forward()[0];
+    return list->holds(node, lookup) ? node : nullptr;
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+template <typename K>
+bool SkipList<Key, Value, Compare, Alloc>::Snapshot::search(const K& key,
+                                                            Value& outValue) const {
+    Node* node = locate(key);
+    const Value* value = node ? visibleValue(node, stamp) : nullptr;
+    if (value) {
+        outValue = *value;
+        return true;
+    }
+    return false;
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+template <typename K>
+bool SkipList<Key, Value, Compare, Alloc>::Snapshot::contains(const K& key) const {
+    Node* node = locate(key);
+    return node && visibleValue(node, stamp);
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+template <typename K>
+auto SkipList<Key, Value, Compare, Alloc>::Snapshot::lower_bound(const K& key) const
+    -> const_iterator {
+    const LookupKey<K>& lookup = key;
+    return const_iterator(list->lastBefore(lookup, false)->forward()[0], stamp);
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+template <typename K>
+size_t SkipList<Key, Value, Compare, Alloc>::Snapshot::rangeQuery(
+    const K& lo, const K& hi, const function<void(const Key&, const Value&)>& callback) const {
+    const LookupKey<K>& last = hi;
+    size_t visited = 0;
+    for (const_iterator it = lower_bound(lo); it != end() && !list->comp(last, it->first); ++it) {
+        callback(it->first, it->second);
+        visited++;
+    }
+    return visited;
+}
+
+// The aisle list is compiled once in SkipList.cpp
+extern template class SkipList<int, string>;
+
 #endif // GOSHOP_SKIPLIST_H
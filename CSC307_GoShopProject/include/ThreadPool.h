@@ -0,0 +1,61 @@
+#ifndef GOSHOP_THREADPOOL_H
+#define GOSHOP_THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+using namespace std;
+class ThreadPool {
+private:
+    // Each worker owns a task deque: it pops its own tasks from the back and
+    // steals from the front of the other workers' deques when it runs dry
+    struct WorkerQueue {
+        mutex lock;
+        deque<function<void()>> tasks;
+    };
+
+    vector<unique_ptr<WorkerQueue>> queues;
+    vector<thread> workers;
+
+    mutex idleLock;
+    condition_variable idleCv;   // wakes sleeping workers when tasks arrive
+    size_t queued;               // tasks pushed but not yet popped (guarded by idleLock)
+    bool stopping;               // set by the destructor (guarded by idleLock)
+    atomic<size_t> nextQueue;    // round-robin target for tasks submitted from outside
+
+    // Pop a task, preferring queue 'self' and stealing from the others
+    bool tryPop(size_t self, function<void()>& task);
+    // Main loop of worker thread 'self'
+    void workerLoop(size_t self);
+
+public:
+    // Constructor: start 'threads' workers (0 means one per hardware thread)
+    explicit ThreadPool(size_t threads = 0);
+    // Destructor: finish queued tasks and join the workers
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Number of worker threads
+    size_t size() const;
+
+    // Queue a task; tasks submitted from a worker go to that worker's own deque
+    void submit(function<void()> task);
+
+    // Run body(i) for every i in [0, count) on the pool and wait for all of them.
+    // The calling thread helps with queued work while it waits, so nested calls
+    // from inside a task cannot deadlock.
+    void parallelFor(size_t count, const function<void(size_t)>& body);
+
+    // Process-wide pool shared by the data structures (created on first use)
+    static ThreadPool& shared();
+};
+
+#endif // GOSHOP_THREADPOOL_H
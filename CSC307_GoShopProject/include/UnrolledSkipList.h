@@ -0,0 +1,515 @@
+#ifndef GOSHOP_UNROLLEDSKIPLIST_H
+#define GOSHOP_UNROLLEDSKIPLIST_H
+
+#include "SkipList.h"  // for IsStreamable
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>  // for rand()
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+// Key blocks are searched with 4-lane integer compares where the target has them
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define GOSHOP_UNROLLED_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define GOSHOP_UNROLLED_NEON 1
+#endif
+using namespace std;
+
+// Unrolled ("B-skiplist") layout of SkipList for large maps. Each node is a block
+// holding up to BlockKeys sorted keys (by default two cache lines of them), and the
+// skip list links blocks by their first key. A lookup therefore chases one pointer
+// per block instead of one per key and finishes with a scan of a contiguous key
+// array: for int keys ordered by less, the block is compared 4 keys at a time with
+// SSE2 or NEON (scalar binary search elsewhere). Blocks split in half when full and
+// merge with their successor when they fall below a quarter full. Values live in a
+// separate array per block so the key array stays dense.
+//
+// Key and Value must be default-constructible. Any insert, update or removal
+// invalidates iterators.
+template <typename Key = int, typename Value = string, typename Compare = less<Key>,
+          size_t BlockKeys = max<size_t>(4, 128 / sizeof(Key))>
+class UnrolledSkipList {
+private:
+    static_assert(BlockKeys >= 4, "blocks need room to split");
+
+    // Blocks of int keys ordered by less are searched with SIMD compares
+    static constexpr bool SIMD_KEYS =
+        is_same_v<Key, int32_t> &&
+        (is_same_v<Compare, less<int32_t>> || is_same_v<Compare, less<>>) &&
+        BlockKeys % 4 == 0;
+
+    // A block: the key array first (cache-line aligned), then the bookkeeping and
+    // level + 1 forward pointers stored right after the block
+    struct alignas(64) Block {
+        Key keys[BlockKeys];   // sorted; with SIMD_KEYS, slots past count hold PAD_KEY
+        Value* values;         // values[i] belongs to keys[i]; null for the head
+        int count;             // keys in use
+        int level;             // highest level this block is linked on
+        Block** forward() { return reinterpret_cast<Block**>(this + 1); }
+    };
+
+    // Hard limit on block levels (the head has them all)
+    static constexpr int LEVEL_CAP = 32;
+    // Smallest value of maxLevel, used while the list is small
+    static constexpr int MIN_MAX_LEVEL = 4;
+    // Probability for level promotion
+    static constexpr float P = 0.5f;
+
+    // Current highest level of any block
+    int level;
+    // Maximum level a new block may get (grows with log2 of the block count)
+    int maxLevel;
+    // Number of keys and of blocks
+    size_t count;
+    size_t blocks;
+    // Key ordering
+    Compare comp;
+    // Header (sentinel) block; holds no keys
+    Block* head;
+
+    // Allocate a block linked on levels 0..lvl (with null links); the head gets no
+    // value array
+    Block* createBlock(int lvl, bool withValues);
+    void destroyBlock(Block* block);
+
+    // Generate a random level for a new block based on probability P
+    int randomLevel() const;
+    // Raise maxLevel to match the current block count
+    void growMaxLevel();
+
+    // Descend to the last block whose first key is <= key, or < key when strict
+    // (head if none). update, when given, receives that predecessor on each level.
+    Block* descend(const Key& key, bool strict, Block** update) const;
+    // Number of keys in block that are ordered before key
+    int position(const Block* block, const Key& key) const;
+    // True if slot index of block holds key
+    bool holds(const Block* block, int index, const Key& key) const {
+        return index < block->count && !comp(key, block->keys[index]);
+    }
+    // Fill the unused key slots from 'from' with PAD_KEY (SIMD blocks only)
+    static void pad(Block* block, int from);
+    // Split a full block: its upper half moves to a new block linked right after it.
+    // update holds the descent's predecessors for a key inside block.
+    Block* split(Block* block, Block** update);
+    // Unlink and free block, whose first key was minKey
+    void unlinkBlock(Block* block, const Key& minKey);
+    // Merge block's successor into it if both fit in three quarters of a block
+    void mergeWithNext(Block* block);
+
+public:
+    // Input iterator over the elements in key order; dereferences to a
+    // (key, value) pair of references
+    class const_iterator {
+    public:
+        typedef input_iterator_tag iterator_category;
+        typedef pair<const Key&, const Value&> value_type;
+        typedef ptrdiff_t difference_type;
+        typedef value_type reference;
+        struct pointer {
+            value_type entry;
+            const value_type* operator->() const { return &entry; }
+        };
+
+        const_iterator() : block(nullptr), index(0) {}
+        reference operator*() const { return {block->keys[index], block->values[index]}; }
+        pointer operator->() const { return {**this}; }
+        const_iterator& operator++() {
+            if (++index == block->count) {
+                block = block->forward()[0];
+                index = 0;
+            }
+            return *this;
+        }
+        const_iterator operator++(int) {
+            const_iterator old = *this;
+            ++*this;
+            return old;
+        }
+        friend bool operator==(const const_iterator& a, const const_iterator& b) {
+            return a.block == b.block && a.index == b.index;
+        }
+        friend bool operator!=(const const_iterator& a, const const_iterator& b) {
+            return !(a == b);
+        }
+
+    private:
+        friend class UnrolledSkipList;
+        const_iterator(Block* b, int i) : block(b), index(i) {}
+        Block* block;  // nullptr is end()
+        int index;
+    };
+
+    // Constructor: initialize an empty list
+    explicit UnrolledSkipList(const Compare& compare = Compare());
+    // Destructor: free all blocks
+    ~UnrolledSkipList();
+
+    UnrolledSkipList(const UnrolledSkipList&) = delete;
+    UnrolledSkipList& operator=(const UnrolledSkipList&) = delete;
+
+    // Insert a key-value pair (returns false if key exists)
+    bool insert(Key key, Value value);
+
+    // Search for a key, output value in outValue if found
+    bool search(const Key& key, Value& outValue) const;
+    bool contains(const Key& key) const;
+
+    // Update the value for an existing key
+    bool update(const Key& key, Value newValue);
+
+    // Remove a key-value pair
+    bool remove(const Key& key);
+
+    // Number of elements and of blocks
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    size_t blockCount() const { return blocks; }
+    // Remove all elements
+    void clear();
+
+    // Display all elements (key and value) in key order
+    void displayList() const;
+
+    // Iteration in key order
+    const_iterator begin() const { return const_iterator(head->forward()[0], 0); }
+    const_iterator end() const { return const_iterator(); }
+};
+
+// UnrolledSkipList Implementation
+
+template <typename Key, typename Value, typename Compare, size_t BlockKeys>
+auto UnrolledSkipList<Key, Value, Compare, BlockKeys>::createBlock(int lvl, bool withValues)
+    -> Block* {
+    size_t bytes = sizeof(Block) + (lvl + 1) * sizeof(Block*);
+    void* memory = ::operator new(bytes, align_val_t(alignof(Block)));
+    Block* block = new (memory) Block();
+    block->values = withValues ? new Value[BlockKeys] : nullptr;
+    block->count = 0;
+    block->level = lvl;
+    for (int i = 0; i <= lvl; ++i) {
+        block->forward()[i] = nullptr;
+    }
+    pad(block, 0);
+    return block;
+}
+
+template <typename Key, typename Value, typename Compare, size_t BlockKeys>
+void UnrolledSkipList<Key, Value, Compare, BlockKeys>::destroyBlock(Block* block) {
+    delete[] block->values;
+    block->~Block();
+    ::operator delete(block, align_val_t(alignof(Block)));
+}
+
+template <typename Key, typename Value, typename Compare, size_t BlockKeys>
+void UnrolledSkipList<Key, Value, Compare, BlockKeys>::pad(Block* block, int from) {
+    if constexpr (SIMD_KEYS) {
+        // Padding compares greater than or equal to every key, so counting the
+        // slots below a key over whole 4-key groups never counts it
+        for (size_t i = from; i < BlockKeys; ++i) {
+            block->keys[i] = numeric_limits<int32_t>::max();
+        }
+    }
+}
+
+template <typename Key, typename Value, typename Compare, size_t BlockKeys>
+UnrolledSkipList<Key, Value, Compare, BlockKeys>::UnrolledSkipList(const Compare& compare)
+    : level(0), maxLevel(MIN_MAX_LEVEL), count(0), blocks(0), comp(compare) {
+    head = createBlock(LEVEL_CAP, false);
+}
+
+template <typename Key, typename Value, typename Compare, size_t BlockKeys>
+UnrolledSkipList<Key, Value, Compare, BlockKeys>::~UnrolledSkipList() {
+    clear();
+    destroyBlock(head);
+}
+
+template <typename Key, typename Value, typename Compare, size_t BlockKeys>
+int UnrolledSkipList<Key, Value, Compare, BlockKeys>::randomLevel() const {
+    int lvl = 0;
+    // Increase level with probability P for each level
+    while (((double) rand() / RAND_MAX) < P && lvl < maxLevel) {
+        lvl++;
+    }
+    return lvl;
+}
+
+template <typename Key, typename Value, typename Compare, size_t BlockKeys>
+void UnrolledSkipList<Key, Value, Compare, BlockKeys>::growMaxLevel() {
+    int wanted = static_cast<int>(bit_width(blocks)) - 1;
+    if (wanted > maxLevel) {
+        maxLevel = min(wanted, LEVEL_CAP);
+    }
+}
+
+template <typename Key, typename Value, typename Compare, size_t BlockKeys>
+auto UnrolledSkipList<Key, Value, Compare, BlockKeys>::descend(const Key& key, bool strict,
+                                                               Block** update) const -> Block* {
+    Block* current = head;
+    // Start from highest level and move down levels, comparing first keys only
+    for (int i = level; i >= 0; --i) {
+        Block* next;
+        while ((next = current->forward()[i]) != nullptr &&
+               (strict ? comp(next->keys[0], key) : !comp(key, next->keys[0]))) {
+            current = next;
+        }
+        if (update) update[i] = current;
+    }
+    return current;
+}
+
+template <typename Key, typename Value, typename Compare, size_t BlockKeys>
+int UnrolledSkipList<Key, Value, Compare, BlockKeys>::position(const Block* block,
+                                                              const Key& key) const {
+    if constexpr (SIMD_KEYS) {
+        // Keys are sorted, so the number below key is its lower-bound position
+        int n = block->count;
+#if defined(GOSHOP_UNROLLED_SSE2)
+        __m128i needle = _mm_set1_epi32(key);
+        int below = 0;
+        for (int i = 0; i < n; i += 4) {
+            __m128i group = _mm_load_si128(reinterpret_cast<const __m128i*>(block->keys + i));
+            int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(group, needle)));
+            below += popcount(static_cast<unsigned>(mask));
+        }
+        return below;
+#elif defined(GOSHOP_UNROLLED_NEON)
+        int32x4_t needle = vdupq_n_s32(key);
+        uint32x4_t below = vdupq_n_u32(0);
+        for (int i = 0; i < n; i += 4) {
+            // Lanes below the needle compare as all ones (-1), so subtracting counts them
+            below = vsubq_u32(below, vcltq_s32(vld1q_s32(block->keys + i), needle));
+        }
+        return static_cast<int>(vaddvq_u32(below));
+#else
+        return static_cast<int>(std::lower_bound(block->keys, block->keys + n, key) -
+                                block->keys);
+#endif
+    } else {
+        return static_cast<int>(std::lower_bound(block->keys, block->keys + block->count, key,
+                                                 comp) - block->keys);
+    }
+}
+
+template <typename Key, typename Value, typename Compare, size_t BlockKeys>
+auto UnrolledSkipList<Key, Value, Compare, BlockKeys>::split(Block* block, Block** update)
+    -> Block* {
+    int newLevel = randomLevel();
+    Block* right = createBlock(newLevel, true);
+    if (newLevel > level) {
+        for (int i = level + 1; i <= newLevel; ++i) {
+            update[i] = head;
+        }
+        level = newLevel;
+    }
+    // Move the upper half of the keys and values over
+    int half = block->count / 2;
+    for (int i = half; i < block->count; ++i) {
+        right->keys[i - half] = std::move(block->keys[i]);
+        right->values[i - half] = std::move(block->values[i]);
+        block->values[i] = Value();
+    }
+    right->count = block->count - half;
+    block->count = half;
+    pad(block, half);
+    // The new block follows 'block' directly: on the levels 'block' is linked on
+    // it is the predecessor, above them the descent's predecessor is
+    for (int i = 0; i <= newLevel; ++i) {
+        Block* pred = (i <= block->level) ? block : update[i];
+        right->forward()[i] = pred->forward()[i];
+        pred->forward()[i] = right;
+    }
+    blocks++;
+    growMaxLevel();
+    return right;
+}
+
+template <typename Key, typename Value, typename Compare, size_t BlockKeys>
+void UnrolledSkipList<Key, Value, Compare, BlockKeys>::unlinkBlock(Block* block,
+                                                                  const Key& minKey) {
+    // Predecessors on each level: the last block before 'block' (which may be empty,
+    // so its own keys are never read)
+    Block* current = head;
+    for (int i = level; i >= 0; --i) {
+        Block* next;
+        while ((next = current->forward()[i]) != nullptr && next != block &&
+               comp(next->keys[0], minKey)) {
+            current = next;
+        }
+        if (i <= block->level && current->forward()[i] == block) {
+            current->forward()[i] = block->forward()[i];
+        }
+    }
+    destroyBlock(block);
+    blocks--;
+    // Reduce level if the highest level is now empty
+    while (level > 0 && head->forward()[level] == nullptr) {
+        level--;
+    }
+}
+
+template <typename Key, typename Value, typename Compare, size_t BlockKeys>
+void UnrolledSkipList<Key, Value, Compare, BlockKeys>::mergeWithNext(Block* block) {
+    Block* next = block->forward()[0];
+    if (!next || static_cast<size_t>(block->count + next->count) > BlockKeys * 3 / 4) return;
+    Key nextMin = next->keys[0];
+    for (int i = 0; i < next->count; ++i) {
+        block->keys[block->count + i] = std::move(next->keys[i]);
+        block->values[block->count + i] = std::move(next->values[i]);
+    }
+    block->count += next->count;
+    unlinkBlock(next, nextMin);
+}
+
+// Insert key and value
+template <typename Key, typename Value, typename Compare, size_t BlockKeys>
+bool UnrolledSkipList<Key, Value, Compare, BlockKeys>::insert(Key key, Value value) {
+    Block* update[LEVEL_CAP + 1];
+    Block* block = descend(key, false, update);
+    if (block == head) {
+        // key comes before every block: it goes to the front of the first one
+        block = head->forward()[0];
+        if (!block) {
+            block = createBlock(0, true);
+            head->forward()[0] = block;
+            update[0] = head;
+            blocks++;
+        }
+    }
+    int index = position(block, key);
+    if (holds(block, index, key)) {
+        cerr << "UnrolledSkipList: Key";
+        if constexpr (IsStreamable<Key>::value) {
+            cerr << " " << key;
+        }
+        cerr << " already exists.\n";
+        return false;
+    }
+    if (static_cast<size_t>(block->count) == BlockKeys) {
+        Block* right = split(block, update);
+        if (index > block->count) {
+            index -= block->count;
+            block = right;
+        }
+    }
+    // Shift the tail up one slot (overwriting one padding slot) and place the key
+    for (int i = block->count; i > index; --i) {
+        block->keys[i] = std::move(block->keys[i - 1]);
+        block->values[i] = std::move(block->values[i - 1]);
+    }
+    block->keys[index] = std::move(key);
+    block->values[index] = std::move(value);
+    block->count++;
+    count++;
+    return true;
+}
+
+// Search for key
+template <typename Key, typename Value, typename Compare, size_t BlockKeys>
+bool UnrolledSkipList<Key, Value, Compare, BlockKeys>::search(const Key& key,
+                                                             Value& outValue) const {
+    Block* block = descend(key, false, nullptr);
+    if (block == head) return false;
+    int index = position(block, key);
+    if (!holds(block, index, key)) return false;
+    outValue = block->values[index];
+    return true;
+}
+
+template <typename Key, typename Value, typename Compare, size_t BlockKeys>
+bool UnrolledSkipList<Key, Value, Compare, BlockKeys>::contains(const Key& key) const {
+    Block* block = descend(key, false, nullptr);
+    return block != head && holds(block, position(block, key), key);
+}
+
+// Update value for an existing key
+template <typename Key, typename Value, typename Compare, size_t BlockKeys>
+bool UnrolledSkipList<Key, Value, Compare, BlockKeys>::update(const Key& key, Value newValue) {
+    Block* block = descend(key, false, nullptr);
+    int index = (block == head) ? 0 : position(block, key);
+    if (block == head || !holds(block, index, key)) {
+        cerr << "UnrolledSkipList: Key";
+        if constexpr (IsStreamable<Key>::value) {
+            cerr << " " << key;
+        }
+        cerr << " not found for update.\n";
+        return false;
+    }
+    block->values[index] = std::move(newValue);
+    return true;
+}
+
+// Remove key
+template <typename Key, typename Value, typename Compare, size_t BlockKeys>
+bool UnrolledSkipList<Key, Value, Compare, BlockKeys>::remove(const Key& key) {
+    Block* block = descend(key, false, nullptr);
+    int index = (block == head) ? 0 : position(block, key);
+    if (block == head || !holds(block, index, key)) {
+        cerr << "UnrolledSkipList: Key";
+        if constexpr (IsStreamable<Key>::value) {
+            cerr << " " << key;
+        }
+        cerr << " not found for deletion.\n";
+        return false;
+    }
+    Key minKey = block->keys[0];
+    // Shift the tail down one slot
+    for (int i = index + 1; i < block->count; ++i) {
+        block->keys[i - 1] = std::move(block->keys[i]);
+        block->values[i - 1] = std::move(block->values[i]);
+    }
+    block->count--;
+    block->values[block->count] = Value();
+    pad(block, block->count);
+    count--;
+    if (block->count == 0) {
+        unlinkBlock(block, minKey);
+    } else if (static_cast<size_t>(block->count) < BlockKeys / 4) {
+        mergeWithNext(block);
+    }
+    return true;
+}
+
+// Remove all elements, keeping the head
+template <typename Key, typename Value, typename Compare, size_t BlockKeys>
+void UnrolledSkipList<Key, Value, Compare, BlockKeys>::clear() {
+    Block* current = head->forward()[0];
+    while (current != nullptr) {
+        Block* next = current->forward()[0];
+        destroyBlock(current);
+        current = next;
+    }
+    for (int i = 0; i <= LEVEL_CAP; ++i) {
+        head->forward()[i] = nullptr;
+    }
+    level = 0;
+    count = 0;
+    blocks = 0;
+}
+
+// Display all key-value pairs
+template <typename Key, typename Value, typename Compare, size_t BlockKeys>
+void UnrolledSkipList<Key, Value, Compare, BlockKeys>::displayList() const {
+    cout << "UnrolledSkipList contents (" << blocks << " blocks):\n";
+    for (Block* block = head->forward()[0]; block != nullptr; block = block->forward()[0]) {
+        for (int i = 0; i < block->count; ++i) {
+            cout << "  Aisle " << block->keys[i] << " -> " << block->values[i] << "\n";
+        }
+    }
+}
+
+// The aisle list layout is compiled once in UnrolledSkipList.cpp
+extern template class UnrolledSkipList<int, string>;
+
+#endif // GOSHOP_UNROLLEDSKIPLIST_H
@@ -11,7 +11,7 @@ using namespace std;
 int main() {
     // Create instances of each data structure
     Graph graph;
-    SkipList skiplist;
+    SkipList<> skiplist;
     DisjointSet ds;
     QuadTree quadtree;
 
@@ -88,6 +88,7 @@ int main() {
                 cout << "5. Update Distance between stores\n";
                 cout << "6. View  full store map\n";
                 cout << "7. Find Shortest shopping route\n";
+                cout << "8. Plan shopping route with multiple stops\n";
                 cout << "0. Back to Main Menu\n";
                 cout << "Enter  your choice: ";
                 int gChoice;
@@ -157,6 +158,40 @@ int main() {
                         }
                         break;
                     }
+                    case 8: {
+                        cout << "Enter start location: ";
+                        getline(cin >> ws, label);
+                        cout << "Enter end location: ";
+                        getline(cin >> ws, label2);
+                        int stopCount;
+                        cout << "How many stops? ";
+                        cin >> stopCount;
+                        vector<string> stops;
+                        for (int i = 0; i < stopCount; ++i) {
+                            string stop;
+                            cout << "Enter stop " << (i + 1) << ": ";
+                            getline(cin >> ws, stop);
+                            stops.push_back(stop);
+                        }
+                        vector<string> stopOrder, path;
+                        int distance;
+                        if (graph.findShoppingRoute(label, label2, stops, stopOrder, path, distance)) {
+                            cout << "Visit the stops in this order: ";
+                            for (size_t i = 0; i < stopOrder.size(); ++i) {
+                                cout << stopOrder[i];
+                                if (i < stopOrder.size() - 1) cout << ", ";
+                            }
+                            cout << "\nFull route (distance " << distance << "): ";
+                            for (size_t i = 0; i < path.size(); ++i) {
+                                cout << path[i];
+                                if (i < path.size() - 1) cout << " -> ";
+                            }
+                            cout << "\n";
+                        } else {
+                            cout << "No valid route found. Check the store names\n";
+                        }
+                        break;
+                    }
                     case 0:
                         back = true;
                         break;
@@ -176,6 +211,8 @@ int main() {
                 cout << "3. Update Aisle Data\n";
                 cout << "4. Remove Aisle Data\n";
                 cout << "5. Display All Aisle Data\n";
+                cout << "6. List Aisles in a Range\n";
+                cout << "7. Find Nearest Aisle at or Below\n";
                 cout << "0. Back to Main Menu\n";
                 cout << "Enter choice: ";
                 int sChoice;
@@ -219,6 +256,30 @@ int main() {
                     case 5:
                         skiplist.displayList();
                         break;
+                    case 6: {
+                        int lastAisle;
+                        cout << "Enter first and last aisle numbers: ";
+                        cin >> aisle >> lastAisle;
+                        size_t listed = skiplist.rangeQuery(aisle, lastAisle,
+                            [](int key, const string& value) {
+                                cout << "  Aisle " << key << " -> " << value << "\n";
+                            });
+                        if (listed == 0) {
+                            cout << "No aisles between " << aisle << " and " << lastAisle << ".\n";
+                        }
+                        break;
+                    }
+                    case 7: {
+                        cout << "Enter aisle number: ";
+                        cin >> aisle;
+                        auto nearest = skiplist.floor(aisle);
+                        if (nearest != skiplist.end()) {
+                            cout << "Nearest: Aisle " << nearest->first << " -> " << nearest->second << "\n";
+                        } else {
+                            cout << "No aisle at or below " << aisle << ".\n";
+                        }
+                        break;
+                    }
                     case 0:
                         back = true;
                         break;
@@ -239,6 +300,7 @@ int main() {
                 cout << "4. Display All Item Groups\n";
                 cout << "5. Remove Item\n";
                 cout << "6. Update Item Name\n";
+                cout << "7. List Items in the Same Group\n";
                 cout << "0. Back to Main Menu\n";
                 cout << "Enter choice: ";
                 string x,y;
@@ -285,6 +347,19 @@ int main() {
                         cin >> y;
                         ds.updateItem(x, y);
                         break;
+                    case 7: {
+                        cout << "Enter item name: ";
+                        getline(cin >> ws, item1);
+                        vector<string> group;
+                        if (ds.members(item1, group)) {
+                            cout << "Group of '" << item1 << "' (" << group.size() << " items):";
+                            for (const string& name : group) {
+                                cout << " " << name;
+                            }
+                            cout << "\n";
+                        }
+                        break;
+                    }
                     case 0:
                         back = true;
                         break;
@@ -303,6 +378,9 @@ int main() {
                 cout << "2. Remove Store\n";
                 cout << "3. Locate Nearest Store\n";
                 cout << "4. Display All available store\n";
+                cout << "5. Move Store\n";
+                cout << "6. Find Closest Stores\n";
+                cout << "7. Find Stores Within a Distance\n";
                 cout << "0. Back to Main Menu\n";
                 cout << "Enter choice: ";
                 int qChoice;
@@ -346,6 +424,44 @@ int main() {
                     case 4:
                         quadtree.printLocations();
                         break;
+                    case 5:
+                        cout << "Enter store name to move: ";
+                        getline(cin >> ws, storeName);
+                        cout << "Enter new X coordinate: ";
+                        cin >> x;
+                        cout << "Enter new Y coordinate: ";
+                        cin >> y;
+                        if (quadtree.move(storeName, x, y)) {
+                            cout << "Moved store '" << storeName << "' to (" << x << ", " << y << ").\n";
+                        }
+                        break;
+                    case 6:
+                    case 7: {
+                        cout << "Enter your location X: ";
+                        cin >> x;
+                        cout << "Enter your location Y: ";
+                        cin >> y;
+                        vector<QuadTree::NearbyStore> nearby;
+                        if (qChoice == 6) {
+                            size_t k;
+                            cout << "How many stores: ";
+                            cin >> k;
+                            quadtree.findKNearest(x, y, k, nearby);
+                        } else {
+                            double radius;
+                            cout << "Enter distance: ";
+                            cin >> radius;
+                            quadtree.findWithinRadius(x, y, radius, nearby);
+                        }
+                        if (nearby.empty()) {
+                            cout << "No stores found.\n";
+                        }
+                        for (const QuadTree::NearbyStore& store : nearby) {
+                            cout << "  " << *store.name << " (" << store.x << ", " << store.y
+                                 << "), distance " << store.distance << "\n";
+                        }
+                        break;
+                    }
                     case 0:
                         back = true;
                         break;
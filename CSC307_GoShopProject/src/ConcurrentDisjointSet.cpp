@@ -0,0 +1,80 @@
+#include "../include/ConcurrentDisjointSet.h"
+#include <algorithm>
+using namespace std;
+// Lock-free union-find (Jayanti-Tarjan style CAS linking with path splitting)
+
+uint32_t ConcurrentDisjointSet::priority(uint32_t id) {
+    // MurmurHash3 finalizer: every step is invertible, so distinct ids get
+    // distinct priorities
+    id ^= id >> 16;
+    id *= 0x85ebca6bu;
+    id ^= id >> 13;
+    id *= 0xc2b2ae35u;
+    id ^= id >> 16;
+    return id;
+}
+
+ConcurrentDisjointSet::ConcurrentDisjointSet(size_t n)
+    : parent(new atomic<uint32_t>[n]), count(n), sets(n) {
+    for (size_t i = 0; i < n; ++i) {
+        parent[i].store(static_cast<uint32_t>(i), memory_order_relaxed);
+    }
+}
+
+uint32_t ConcurrentDisjointSet::find(uint32_t id) {
+    while (true) {
+        uint32_t up = parent[id].load(memory_order_acquire);
+        if (up == id) return id;
+        uint32_t grand = parent[up].load(memory_order_acquire);
+        if (grand == up) return up;
+        // Path splitting: point id at its grandparent. Parents only ever move
+        // closer to the root, so a failed CAS just means someone else did it.
+        parent[id].compare_exchange_weak(up, grand, memory_order_release,
+                                         memory_order_relaxed);
+        id = up;
+    }
+}
+
+bool ConcurrentDisjointSet::unite(uint32_t a, uint32_t b) {
+    while (true) {
+        a = find(a);
+        b = find(b);
+        if (a == b) return false;
+        // The lower-priority root goes under the other one
+        if (priority(a) > priority(b)) swap(a, b);
+        uint32_t expected = a;
+        if (parent[a].compare_exchange_strong(expected, b, memory_order_acq_rel,
+                                              memory_order_relaxed)) {
+            sets.fetch_sub(1, memory_order_relaxed);
+            return true;
+        }
+        // a was linked by another thread meanwhile; start again from the new roots
+    }
+}
+
+bool ConcurrentDisjointSet::sameSet(uint32_t a, uint32_t b) {
+    while (true) {
+        a = find(a);
+        b = find(b);
+        if (a == b) return true;
+        // Different roots only prove different sets if a is still a root
+        if (parent[a].load(memory_order_acquire) == a) return false;
+    }
+}
+
+size_t ConcurrentDisjointSet::unionBatch(const vector<pair<uint32_t, uint32_t>>& edges,
+                                         ThreadPool& pool) {
+    // Contiguous slices keep each worker streaming through its part of the list;
+    // several per worker let stealing even out slices with more contention
+    size_t slices = min(edges.size(), pool.size() * 8);
+    if (slices == 0) return components();
+    size_t sliceSize = (edges.size() + slices - 1) / slices;
+    pool.parallelFor(slices, [&](size_t s) {
+        size_t first = s * sliceSize;
+        size_t last = min(edges.size(), first + sliceSize);
+        for (size_t i = first; i < last; ++i) {
+            unite(edges[i].first, edges[i].second);
+        }
+    });
+    return components();
+}
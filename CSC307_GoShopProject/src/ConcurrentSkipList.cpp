@@ -0,0 +1,385 @@
+#include "../include/ConcurrentSkipList.h"
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <climits>  // for INT_MIN
+#include <bit>      // for countr_one
+using namespace std;
+// Lock-free skip list (Herlihy-Shavit style marked links) with epoch-based reclamation
+
+// ---------------------------------------------------------------------------
+// Epoch-based reclamation shared by every ConcurrentSkipList in the process.
+//
+// Each thread announces the global epoch while it is inside an operation. Memory
+// unlinked during epoch e is parked in the retiring thread's bag for e and freed
+// once the global epoch reaches e + 2: the epoch only advances when every active
+// thread has announced the current one, so by then no thread can still hold a
+// pointer obtained before the memory was unlinked.
+// ---------------------------------------------------------------------------
+
+namespace {
+
+struct Retired {
+    void* object;
+    void (*destroy)(void*);
+};
+
+// Per-thread announcement plus its three bags of retired memory (indexed by epoch % 3).
+// Records are never freed; a record left behind by an exited thread is adopted by the
+// next new thread, together with whatever is still in its bags.
+struct EpochRecord {
+    atomic<uint64_t> announced{0};  // (epoch << 1) | 1 while inside an operation, else 0
+    atomic<bool> owned{false};
+    EpochRecord* nextRecord = nullptr;
+    unsigned depth = 0;             // nesting of guards on the owning thread
+    uint64_t bagEpoch[3] = {0, 0, 0};
+    vector<Retired> bags[3];
+};
+
+atomic<uint64_t> globalEpoch{2};  // starts at 2 so "epoch - 2" never underflows
+atomic<EpochRecord*> epochRecords{nullptr};
+
+// Retired objects a thread accumulates before it tries to advance the epoch
+const size_t RECLAIM_THRESHOLD = 64;
+
+EpochRecord* acquireRecord() {
+    for (EpochRecord* rec = epochRecords.load(); rec; rec = rec->nextRecord) {
+        bool expected = false;
+        if (!rec->owned.load() && rec->owned.compare_exchange_strong(expected, true)) {
+            return rec;
+        }
+    }
+    EpochRecord* rec = new EpochRecord();
+    rec->owned.store(true);
+    EpochRecord* first = epochRecords.load();
+    do {
+        rec->nextRecord = first;
+    } while (!epochRecords.compare_exchange_weak(first, rec));
+    return rec;
+}
+
+// Owns the calling thread's record and releases it when the thread exits
+struct ThreadEpoch {
+    EpochRecord* record = acquireRecord();
+    ~ThreadEpoch() {
+        record->announced.store(0);
+        record->owned.store(false);
+    }
+};
+
+EpochRecord& localRecord() {
+    static thread_local ThreadEpoch self;
+    return *self.record;
+}
+
+// Free the bags of epochs that every thread has moved past
+void freeExpiredBags(EpochRecord& rec, uint64_t epoch) {
+    for (int i = 0; i < 3; ++i) {
+        if (!rec.bags[i].empty() && rec.bagEpoch[i] + 2 <= epoch) {
+            for (const Retired& r : rec.bags[i]) {
+                r.destroy(r.object);
+            }
+            rec.bags[i].clear();
+        }
+    }
+}
+
+// Advance the global epoch if every active thread has announced the current one
+void tryAdvanceEpoch() {
+    uint64_t epoch = globalEpoch.load();
+    for (EpochRecord* rec = epochRecords.load(); rec; rec = rec->nextRecord) {
+        uint64_t announced = rec->announced.load();
+        if ((announced & 1) && (announced >> 1) != epoch) {
+            return;
+        }
+    }
+    globalEpoch.compare_exchange_strong(epoch, epoch + 1);
+}
+
+// RAII critical section: pointers read from the list stay valid until it ends
+class EpochGuard {
+private:
+    EpochRecord& rec;
+
+public:
+    EpochGuard() : rec(localRecord()) {
+        if (rec.depth++ == 0) {
+            // Announce, then make sure the announcement is of the current epoch
+            uint64_t epoch = globalEpoch.load();
+            rec.announced.store((epoch << 1) | 1);
+            uint64_t now;
+            while ((now = globalEpoch.load()) != epoch) {
+                epoch = now;
+                rec.announced.store((epoch << 1) | 1);
+            }
+            freeExpiredBags(rec, epoch);
+        }
+    }
+    ~EpochGuard() {
+        if (--rec.depth == 0) {
+            rec.announced.store(0);
+        }
+    }
+    EpochGuard(const EpochGuard&) = delete;
+    EpochGuard& operator=(const EpochGuard&) = delete;
+};
+
+// Park unlinked memory until no thread can still reach it
+void retireObject(void* object, void (*destroy)(void*)) {
+    EpochRecord& rec = localRecord();
+    uint64_t epoch = globalEpoch.load();
+    size_t slot = epoch % 3;
+    if (rec.bagEpoch[slot] != epoch) {
+        // The slot still holds epoch - 3 (already safe to free) or is empty
+        for (const Retired& r : rec.bags[slot]) {
+            r.destroy(r.object);
+        }
+        rec.bags[slot].clear();
+        rec.bagEpoch[slot] = epoch;
+    }
+    rec.bags[slot].push_back({object, destroy});
+    if (rec.bags[slot].size() >= RECLAIM_THRESHOLD) {
+        tryAdvanceEpoch();
+    }
+}
+
+void destroyString(void* object) {
+    delete static_cast<const string*>(object);
+}
+
+// Per-thread xorshift generator for node heights
+uint64_t nextRandom() {
+    static thread_local uint64_t state =
+        (static_cast<uint64_t>(chrono::steady_clock::now().time_since_epoch().count()) ^
+         hash<thread::id>()(this_thread::get_id())) | 1;
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+}  // namespace
+
+// ---------------------------------------------------------------------------
+
+const unsigned ConcurrentSkipList::INSERTING = 1;
+const unsigned ConcurrentSkipList::REMOVED = 2;
+
+ConcurrentSkipList::Node::Node(int k, const string* val, int h)
+    : key(k), value(val), height(h), next(new atomic<uintptr_t>[h]), state(INSERTING) {
+    for (int i = 0; i < h; ++i) {
+        next[i].store(0, memory_order_relaxed);
+    }
+}
+
+ConcurrentSkipList::Node::~Node() {
+    delete value.load();
+    delete[] next;
+}
+
+ConcurrentSkipList::Node* ConcurrentSkipList::pointer(uintptr_t link) {
+    return reinterpret_cast<Node*>(link & ~uintptr_t(1));
+}
+
+bool ConcurrentSkipList::marked(uintptr_t link) {
+    return (link & 1) != 0;
+}
+
+ConcurrentSkipList::ConcurrentSkipList() : count(0) {
+    // Sentinel with key INT_MIN on every level; its key is never compared
+    head = new Node(INT_MIN, nullptr, MAX_HEIGHT);
+    head->state.store(0);
+}
+
+ConcurrentSkipList::~ConcurrentSkipList() {
+    // Everything still on level 0 belongs to the list; retired nodes are already unlinked
+    Node* current = pointer(head->next[0].load());
+    while (current != nullptr) {
+        Node* next = pointer(current->next[0].load());
+        delete current;
+        current = next;
+    }
+    delete head;
+}
+
+int ConcurrentSkipList::randomHeight() {
+    // Each extra level with probability 1/2: count the trailing one bits
+    int height = 1 + countr_one(nextRandom());
+    return height < MAX_HEIGHT ? height : MAX_HEIGHT;
+}
+
+void ConcurrentSkipList::retire(Node* node) {
+    retireObject(node, [](void* object) { delete static_cast<Node*>(object); });
+}
+
+bool ConcurrentSkipList::find(int key, Node** preds, Node** succs) const {
+retry:
+    Node* pred = head;
+    for (int level = MAX_HEIGHT - 1; level >= 0; --level) {
+        Node* curr = pointer(pred->next[level].load());
+        while (curr != nullptr) {
+            uintptr_t succLink = curr->next[level].load();
+            // Unlink logically deleted nodes; if pred changed under us, start over
+            while (marked(succLink)) {
+                uintptr_t expected = reinterpret_cast<uintptr_t>(curr);
+                if (!pred->next[level].compare_exchange_strong(expected, succLink & ~uintptr_t(1))) {
+                    goto retry;
+                }
+                curr = pointer(succLink);
+                if (curr == nullptr) break;
+                succLink = curr->next[level].load();
+            }
+            if (curr == nullptr || curr->key >= key) break;
+            pred = curr;
+            curr = pointer(succLink);
+        }
+        preds[level] = pred;
+        succs[level] = curr;
+    }
+    return succs[0] != nullptr && succs[0]->key == key;
+}
+
+bool ConcurrentSkipList::insert(int key, const string& value) {
+    EpochGuard guard;
+    Node* preds[MAX_HEIGHT];
+    Node* succs[MAX_HEIGHT];
+    int height = randomHeight();
+    Node* node = nullptr;
+
+    // Publish the node on level 0; that CAS is the linearization point
+    while (true) {
+        if (find(key, preds, succs)) {
+            delete node;  // never published
+            return false;
+        }
+        if (node == nullptr) {
+            node = new Node(key, new string(value), height);
+        }
+        for (int i = 0; i < height; ++i) {
+            node->next[i].store(reinterpret_cast<uintptr_t>(succs[i]), memory_order_relaxed);
+        }
+        uintptr_t expected = reinterpret_cast<uintptr_t>(succs[0]);
+        if (preds[0]->next[0].compare_exchange_strong(expected, reinterpret_cast<uintptr_t>(node))) {
+            break;
+        }
+    }
+    count.fetch_add(1);
+
+    // Link the upper levels; give up as soon as a remover has marked the node
+    for (int level = 1; level < height; ++level) {
+        while (true) {
+            uintptr_t link = node->next[level].load();
+            if (marked(link)) goto linked;
+            uintptr_t succ = reinterpret_cast<uintptr_t>(succs[level]);
+            if (link != succ && !node->next[level].compare_exchange_strong(link, succ)) {
+                continue;  // marked meanwhile (rechecked above)
+            }
+            uintptr_t expected = succ;
+            if (preds[level]->next[level].compare_exchange_strong(
+                    expected, reinterpret_cast<uintptr_t>(node))) {
+                break;
+            }
+            // Neighbourhood changed: refresh, and stop if the node is already gone
+            find(key, preds, succs);
+            if (succs[0] != node) goto linked;
+        }
+    }
+
+linked:
+    // A remover that finished while we were still linking may have missed a level
+    if (marked(node->next[0].load())) {
+        find(key, preds, succs);
+    }
+    if (node->state.fetch_and(~INSERTING) & REMOVED) {
+        retire(node);
+    }
+    return true;
+}
+
+bool ConcurrentSkipList::search(int key, string& outValue) const {
+    EpochGuard guard;
+    // Read-only descent: marked nodes are skipped rather than unlinked
+    Node* pred = head;
+    Node* curr = nullptr;
+    for (int level = MAX_HEIGHT - 1; level >= 0; --level) {
+        curr = pointer(pred->next[level].load());
+        while (curr != nullptr) {
+            uintptr_t succLink = curr->next[level].load();
+            if (marked(succLink)) {
+                curr = pointer(succLink);
+                continue;
+            }
+            if (curr->key >= key) break;
+            pred = curr;
+            curr = pointer(succLink);
+        }
+    }
+    if (curr == nullptr || curr->key != key || marked(curr->next[0].load())) {
+        return false;
+    }
+    outValue = *curr->value.load();
+    return true;
+}
+
+bool ConcurrentSkipList::update(int key, const string& newValue) {
+    EpochGuard guard;
+    Node* preds[MAX_HEIGHT];
+    Node* succs[MAX_HEIGHT];
+    if (!find(key, preds, succs)) {
+        return false;
+    }
+    const string* old = succs[0]->value.exchange(new string(newValue));
+    retireObject(const_cast<string*>(old), destroyString);
+    return true;
+}
+
+bool ConcurrentSkipList::remove(int key) {
+    EpochGuard guard;
+    Node* preds[MAX_HEIGHT];
+    Node* succs[MAX_HEIGHT];
+    if (!find(key, preds, succs)) {
+        return false;
+    }
+    Node* node = succs[0];
+    // Mark the upper levels top-down so no new links can be made to them
+    for (int level = node->height - 1; level >= 1; --level) {
+        uintptr_t link = node->next[level].load();
+        while (!marked(link) && !node->next[level].compare_exchange_weak(link, link | 1)) {
+        }
+    }
+    // Marking level 0 is the linearization point; only one remover can win it
+    uintptr_t link = node->next[0].load();
+    while (true) {
+        if (marked(link)) {
+            return false;
+        }
+        if (node->next[0].compare_exchange_strong(link, link | 1)) {
+            break;
+        }
+    }
+    count.fetch_sub(1);
+    // Unlink it everywhere, then retire it unless the inserter is still linking
+    find(key, preds, succs);
+    if (!(node->state.fetch_or(REMOVED) & INSERTING)) {
+        retire(node);
+    }
+    return true;
+}
+
+size_t ConcurrentSkipList::size() const {
+    return count.load();
+}
+
+void ConcurrentSkipList::displayList() const {
+    EpochGuard guard;
+    cout << "ConcurrentSkipList contents (level 0):\n";
+    Node* node = pointer(head->next[0].load());
+    while (node != nullptr) {
+        uintptr_t link = node->next[0].load();
+        if (!marked(link)) {
+            cout << "  Aisle " << node->key << " -> " << *node->value.load() << "\n";
+        }
+        node = pointer(link);
+    }
+}
@@ -1,92 +1,313 @@
 #include "../include/DisjointSet.h"
+#include "../include/ConcurrentDisjointSet.h"
+#include "../include/ThreadPool.h"
+#include <atomic>
+#include <utility>
 #include <vector>
 using namespace std;
-// Disjoint Set (Union-Find) Implementation with path compression and union by rank
+// Disjoint Set (Union-Find) Implementation with path halving, union by rank and
+// vacant-node deletion
 
-string DisjointSet::findSet(const string& x) {
-    if (parent.find(x) == parent.end()) return x;
-    if (parent[x] != x) {
-        parent[x] = findSet(parent[x]);
+uint32_t DisjointSet::idOf(const string& x) const {
+    auto it = ids.find(x);
+    return it == ids.end() ? NO_ID : it->second;
+}
+
+uint32_t DisjointSet::existingId(const string& x) const {
+    uint32_t id = idOf(x);
+    if (id == NO_ID) {
+        cerr << "DisjointSet: Element '" << x << "' not found or removed.\n";
+    }
+    return id;
+}
+
+void DisjointSet::reserve(size_t n) {
+    parent.reserve(n);
+    rank.reserve(n);
+    next.reserve(n);
+    slots.reserve(n);
+    leader.reserve(n);
+    items.reserve(n);
+    nodes.reserve(n);
+    names.reserve(n);
+    ids.reserve(n);
+}
+
+uint32_t DisjointSet::allocateId() {
+    uint32_t id;
+    if (!freeIds.empty()) {
+        id = freeIds.back();
+        freeIds.pop_back();
+    } else {
+        id = static_cast<uint32_t>(parent.size());
+        parent.push_back(id);
+        rank.push_back(0);
+        next.push_back(id);
+        slots.push_back(Slot::Free);
+        leader.push_back(id);
+        items.push_back(0);
+        nodes.push_back(0);
+        names.emplace_back();
     }
-    return parent[x];
+    parent[id] = id;
+    rank[id] = 0;
+    next[id] = id;
+    slots[id] = Slot::Occupied;
+    leader[id] = id;
+    items[id] = 1;
+    nodes[id] = 1;
+    return id;
+}
+
+uint32_t DisjointSet::findRoot(uint32_t id) {
+    // Path halving: point every other node on the way at its grandparent, which
+    // keeps trees flat without recursion or a second pass
+    while (parent[id] != id) {
+        parent[id] = parent[parent[id]];
+        id = parent[id];
+    }
+    return id;
+}
+
+uint32_t DisjointSet::rootOf(uint32_t id) const {
+    while (parent[id] != id) {
+        id = parent[id];
+    }
+    return id;
+}
+
+bool DisjointSet::unionIds(uint32_t a, uint32_t b) {
+    uint32_t rootA = findRoot(a);
+    uint32_t rootB = findRoot(b);
+    if (rootA == rootB) return false;
+
+    if (rank[rootA] < rank[rootB]) {
+        swap(rootA, rootB);
+    } else if (rank[rootA] == rank[rootB]) {
+        rank[rootA]++;
+    }
+    // rootA absorbs rootB and keeps its leader
+    parent[rootB] = rootA;
+    items[rootA] += items[rootB];
+    nodes[rootA] += nodes[rootB];
+    // Exchanging one successor in each ring joins the two rings into one
+    swap(next[rootA], next[rootB]);
+    setCount--;
+    return true;
+}
+
+uint32_t DisjointSet::rebuildSet(uint32_t root) {
+    uint32_t head = leader[root];
+    vector<uint32_t> members;
+    members.reserve(items[root]);
+    uint32_t id = root;
+    do {
+        uint32_t following = next[id];
+        if (slots[id] == Slot::Occupied) {
+            members.push_back(id);
+        } else {
+            slots[id] = Slot::Free;
+            freeIds.push_back(id);
+        }
+        id = following;
+    } while (id != root);
+
+    for (size_t i = 0; i < members.size(); ++i) {
+        parent[members[i]] = head;
+        rank[members[i]] = 0;
+        next[members[i]] = members[(i + 1) % members.size()];
+    }
+    rank[head] = members.size() > 1 ? 1 : 0;
+    leader[head] = head;
+    items[head] = nodes[head] = static_cast<uint32_t>(members.size());
+    return head;
 }
 
 bool DisjointSet::makeSet(const string& x) {
-    if (parent.find(x) != parent.end()) {
+    if (ids.count(x)) {
         cerr << "DisjointSet: Element '" << x << "' already exists.\n";
         return false;
     }
-    parent[x] = x;
-    rank[x] = 0;
-    active[x] = true;
+    if (freeIds.empty() && parent.size() == NO_ID) {
+        cerr << "DisjointSet: Too many elements.\n";
+        return false;
+    }
+    uint32_t id = allocateId();
+    names[id] = x;
+    ids.emplace(x, id);
+    setCount++;
     return true;
 }
 
 bool DisjointSet::find(const string& x, string& outRepresentative) {
-    if (parent.find(x) == parent.end() || !active[x]) {
-        cerr << "DisjointSet: Element '" << x << "' not found or removed.\n";
-        return false;
-    }
-    outRepresentative = findSet(x);
+    uint32_t id = existingId(x);
+    if (id == NO_ID) return false;
+    outRepresentative = names[representative(id)];
     return true;
 }
 
 bool DisjointSet::unionSets(const string& x, const string& y) {
-    if (!active[x] || !active[y]) {
-        cerr << "DisjointSet: One or both elements are removed.\n";
+    uint32_t idX = idOf(x);
+    uint32_t idY = idOf(y);
+    if (idX == NO_ID || idY == NO_ID) {
+        cerr << "DisjointSet: One or both elements are missing or removed.\n";
         return false;
     }
-    string rootX = findSet(x);
-    string rootY = findSet(y);
-    if (rootX == rootY) return false;
+    return unionIds(idX, idY);
+}
 
-    if (rank[rootX] < rank[rootY]) {
-        parent[rootX] = rootY;
-    } else if (rank[rootX] > rank[rootY]) {
-        parent[rootY] = rootX;
-    } else {
-        parent[rootY] = rootX;
-        rank[rootX]++;
+size_t DisjointSet::unionBatch(const vector<pair<string, string>>& pairs) {
+    // The workers only read this DisjointSet; every merge goes into 'merged', whose
+    // ids are ours and which starts out with only singletons, so it only ever links
+    // our current roots to each other
+    ConcurrentDisjointSet merged(parent.size());
+    atomic<size_t> skipped{0};
+    ThreadPool::shared().parallelFor(pairs.size(), [&](size_t i) {
+        uint32_t idX = idOf(pairs[i].first);
+        uint32_t idY = idOf(pairs[i].second);
+        if (idX == NO_ID || idY == NO_ID) {
+            skipped.fetch_add(1, memory_order_relaxed);
+            return;
+        }
+        merged.unite(rootOf(idX), rootOf(idY));
+    });
+    if (skipped.load() > 0) {
+        cerr << "DisjointSet: Skipped " << skipped.load()
+             << " pairs with missing or removed elements.\n";
     }
-    return true;
+    if (merged.components() == parent.size()) return setCount;
+
+    // Fold back: each old root that was linked joins its merged root here
+    for (uint32_t id = 0; id < parent.size(); ++id) {
+        uint32_t root = merged.find(id);
+        if (root != id) unionIds(id, root);
+    }
+    return setCount;
 }
 
 bool DisjointSet::removeItem(const string& x) {
-    if (active.find(x) == active.end() || !active[x]) {
+    uint32_t id = idOf(x);
+    if (id == NO_ID) {
         cerr << "DisjointSet: Item not found or already removed.\n";
         return false;
     }
-    active[x] = false;
+    uint32_t root = findRoot(id);
+    ids.erase(x);
+    string().swap(names[id]);
+    slots[id] = Slot::Vacant;
+    items[root]--;
+
+    if (items[root] == 0) {
+        // Last item of the set: every node in its ring is free now
+        uint32_t node = root;
+        do {
+            slots[node] = Slot::Free;
+            freeIds.push_back(node);
+            node = next[node];
+        } while (node != root);
+        setCount--;
+        return true;
+    }
+    if (leader[root] == id) {
+        // Re-elect: the next item along the ring represents the set from now on
+        uint32_t node = next[id];
+        while (slots[node] != Slot::Occupied) {
+            node = next[node];
+        }
+        leader[root] = node;
+    }
+    if (nodes[root] > 2 * items[root]) {
+        rebuildSet(root);
+    }
     return true;
 }
 
 bool DisjointSet::updateItem(const string& oldName, const string& newName) {
-    if (!active[oldName]) {
+    uint32_t id = idOf(oldName);
+    if (id == NO_ID) {
         cerr << "DisjointSet: Cannot update non-existing item.\n";
         return false;
     }
-    string rep;
-    if (!find(oldName, rep)) return false;
+    if (ids.count(newName)) {
+        cerr << "DisjointSet: Element '" << newName << "' already exists.\n";
+        return false;
+    }
+    ids.erase(oldName);
+    names[id] = newName;
+    ids.emplace(newName, id);
+    return true;
+}
+
+void DisjointSet::compact() {
+    // New ids are handed out set by set, leader first, so every set becomes a star
+    // over a contiguous id range
+    size_t count = ids.size();
+    vector<uint32_t> newParent(count), newNext(count), newLeader(count);
+    vector<uint32_t> newItems(count), newNodes(count);
+    vector<uint8_t> newRank(count, 0);
+    vector<string> newNames(count);
+    uint32_t assigned = 0;
+    for (uint32_t root = 0; root < parent.size(); ++root) {
+        if (slots[root] == Slot::Free || parent[root] != root) continue;
+        uint32_t first = assigned;
+        newNames[assigned++] = std::move(names[leader[root]]);
+        uint32_t id = root;
+        do {
+            if (slots[id] == Slot::Occupied && id != leader[root]) {
+                newNames[assigned++] = std::move(names[id]);
+            }
+            id = next[id];
+        } while (id != root);
+        for (uint32_t i = first; i < assigned; ++i) {
+            newParent[i] = first;
+            newNext[i] = (i + 1 < assigned) ? i + 1 : first;
+            newLeader[i] = i;
+            newItems[i] = newNodes[i] = 1;
+        }
+        newRank[first] = (assigned - first > 1) ? 1 : 0;
+        newItems[first] = newNodes[first] = assigned - first;
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        ids[newNames[i]] = i;
+    }
+
+    parent = std::move(newParent);
+    rank = std::move(newRank);
+    next = std::move(newNext);
+    slots.assign(count, Slot::Occupied);
+    slots.shrink_to_fit();
+    leader = std::move(newLeader);
+    items = std::move(newItems);
+    nodes = std::move(newNodes);
+    names = std::move(newNames);
+    vector<uint32_t>().swap(freeIds);
+    ids.rehash(0);
+}
+
+bool DisjointSet::members(const string& x, vector<string>& outMembers) {
+    uint32_t id = existingId(x);
+    if (id == NO_ID) return false;
+    Set set(this, findRoot(id));
+    outMembers.assign(set.begin(), set.end());
+    return true;
+}
 
-    makeSet(newName);
-    unionSets(newName, rep);
-    removeItem(oldName);
+bool DisjointSet::setSize(const string& x, size_t& outSize) {
+    uint32_t id = existingId(x);
+    if (id == NO_ID) return false;
+    outSize = items[findRoot(id)];
     return true;
 }
 
 void DisjointSet::printSets() {
-    map<string, vector<string>> sets;
-    for (auto& kv : parent) {
-        if (!active[kv.first]) continue;
-        string root = findSet(kv.first);
-        sets[root].push_back(kv.first);
-    }
-    cout << "Disjoint Set contents:\n";
-    for (auto& kv : sets) {
-        cout << "  Set representative: " << kv.first << " -> { ";
-        for (size_t i = 0; i < kv.second.size(); ++i) {
-            cout << kv.second[i];
-            if (i < kv.second.size() - 1) cout << ", ";
+    cout << "Disjoint Set contents (" << setCount << " sets):\n";
+    for (const Set& set : *this) {
+        cout << "  Set representative: " << set.representative() << " -> { ";
+        bool first = true;
+        for (const string& name : set) {
+            if (!first) cout << ", ";
+            cout << name;
+            first = false;
         }
         cout << " }\n";
     }
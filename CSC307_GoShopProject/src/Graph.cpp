@@ -1,74 +1,182 @@
 #include "Graph.h"
-#include <algorithm>  // for remove_if
+#include "ThreadPool.h"
+#include <algorithm>
 #include <queue>
 #include <limits>
+#include <functional>  // for greater
+#include <cmath>       // for hypot
 using namespace std;
 
-bool Graph::addVertex(const string& label) {
+// Walk a parent array back from 'to' and append the ids in source-to-'to' order
+static void appendTreePath(const vector<uint32_t>& prev, uint32_t to, vector<uint32_t>& idPath) {
+    size_t first = idPath.size();
+    for (uint32_t cur = to; cur != UINT32_MAX; cur = prev[cur]) {
+        idPath.push_back(cur);
+    }
+    reverse(idPath.begin() + first, idPath.end());
+}
+
+// Key of a (start, end) pair in the path cache
+static string pathCacheKey(const string& start, const string& end) {
+    string key = start;
+    key.push_back('\0');
+    key += end;
+    return key;
+}
+
+// Label-setting loop shared by the Dijkstra kernels. The queue already holds the
+// source; settle(u) is called for each finalized vertex and returns true to stop,
+// improve(v, u) is called just before dist[v] is lowered through u. Entries whose
+// key exceeds the vertex's distance are stale (the bucket queue keeps duplicates).
+// Returns the number of vertices settled.
+template <typename CSR, typename Queue, typename Weight, typename Settle, typename Improve>
+static size_t runDijkstra(const CSR& g, Queue& queue, vector<Weight>& dist,
+                          Settle settle, Improve improve) {
+    size_t settled = 0;
+    while (!queue.empty()) {
+        auto [distU, u] = queue.pop();
+        if (distU > dist[u]) continue;
+        settled++;
+        if (settle(u)) break;
+        for (uint32_t e = g.offsets[u]; e < g.offsets[u + 1]; ++e) {
+            uint32_t v = g.neighbors[e];
+            Weight candidate = WeightTraits<Weight>::add(distU, g.weights[e]);
+            if (candidate < dist[v]) {
+                improve(v, u);
+                dist[v] = candidate;
+                queue.push(v, candidate);
+            }
+        }
+    }
+    return settled;
+}
+
+template <typename Weight>
+bool BasicGraph<Weight>::addVertex(const string& label) {
     if (adjList.find(label) != adjList.end()) {
         cerr << "Vertex '" << label << "' already exists.\n";
         return false;
     }
-    adjList[label] = vector<pair<string, int>>();
+    adjList[label] = unordered_map<string, Weight>();
+    markEdited();
+    {
+        // A new vertex shifts the compiled ids, which retires the cached trees
+        lock_guard<mutex> guard(cacheLock);
+        vertexSetVersion++;
+    }
     return true;
 }
 
-bool Graph::removeVertex(const string& label) {
+template <typename Weight>
+bool BasicGraph<Weight>::addVertex(const string& label, double x, double y) {
+    if (!addVertex(label)) return false;
+    coords[label] = {x, y};
+    return true;
+}
+
+template <typename Weight>
+bool BasicGraph<Weight>::removeVertex(const string& label) {
     auto it = adjList.find(label);
     if (it == adjList.end()) {
         cerr << "Vertex '" << label << "' not found.\n";
         return false;
     }
-    for (auto& kv : adjList) {
-        if (kv.first == label) continue;
-        auto& neighbors = kv.second;
-        neighbors.erase(
-            remove_if(neighbors.begin(), neighbors.end(),
-                      [&](const pair<string, int>& p){ return p.first == label; }),
-            neighbors.end()
-        );
+    // Only the vertex's own neighbors can refer to it
+    for (const auto& edge : it->second) {
+        if (edge.first != label) {
+            adjList[edge.first].erase(label);
+        }
     }
-    adjList.erase(label);
+    adjList.erase(it);
+    coords.erase(label);
+    markEdited();
+    invalidateCachesForVertices([&](const string& v) { return v == label; });
     return true;
 }
 
-bool Graph::addEdge(const string& src, const string& dest, int weight) {
+template <typename Weight>
+size_t BasicGraph<Weight>::removeVertices(const vector<string>& labels) {
+    // Resolve the whole batch first so edges between two doomed vertices are
+    // dropped together with their endpoints instead of one side at a time
+    unordered_map<string, typename map<string, unordered_map<string, Weight>>::iterator> doomed;
+    for (const string& label : labels) {
+        auto it = adjList.find(label);
+        if (it == adjList.end()) {
+            cerr << "Vertex '" << label << "' not found.\n";
+            continue;
+        }
+        doomed.emplace(label, it);
+    }
+    for (const auto& entry : doomed) {
+        for (const auto& edge : entry.second->second) {
+            if (doomed.find(edge.first) == doomed.end()) {
+                adjList[edge.first].erase(entry.first);
+            }
+        }
+    }
+    for (const auto& entry : doomed) {
+        adjList.erase(entry.second);
+        coords.erase(entry.first);
+    }
+    if (!doomed.empty()) {
+        markEdited();
+        invalidateCachesForVertices([&](const string& v) { return doomed.count(v) > 0; });
+    }
+    return doomed.size();
+}
+
+template <typename Weight>
+bool BasicGraph<Weight>::checkWeight(Weight weight) {
     if (weight < 0) {
         cerr << "Edge weight cannot be negative.\n";
         return false;
     }
-    if (adjList.find(src) == adjList.end() || adjList.find(dest) == adjList.end()) {
-        cerr << "One or both vertices not found.\n";
+    // NaN fails every comparison; UNREACHABLE is reserved for "no path"
+    if (!(weight < UNREACHABLE)) {
+        cerr << "Edge weight is out of range.\n";
         return false;
     }
-    adjList[src].push_back({dest, weight});
-    adjList[dest].push_back({src, weight});
     return true;
 }
 
-bool Graph::removeEdge(const string& src, const string& dest) {
-    if (adjList.find(src) == adjList.end() || adjList.find(dest) == adjList.end()) {
+template <typename Weight>
+bool BasicGraph<Weight>::addEdge(const string& src, const string& dest, Weight weight) {
+    if (!checkWeight(weight)) return false;
+    auto srcIt = adjList.find(src);
+    auto destIt = adjList.find(dest);
+    if (srcIt == adjList.end() || destIt == adjList.end()) {
         cerr << "One or both vertices not found.\n";
         return false;
     }
-    bool removed = false;
-
-    auto& srcNeighbors = adjList[src];
-    for (auto it = srcNeighbors.begin(); it != srcNeighbors.end(); ++it) {
-        if (it->first == dest) {
-            srcNeighbors.erase(it);
-            removed = true;
-            break;
-        }
+    if (srcIt->second.find(dest) != srcIt->second.end()) {
+        cerr << "Edge '" << src << " - " << dest << "' already exists.\n";
+        return false;
     }
+    srcIt->second[dest] = weight;
+    destIt->second[src] = weight;
+    markEdited();
+    invalidateCachesForEdge(src, dest, UNREACHABLE, weight);
+    repairWatchedTrees(src, dest, UNREACHABLE, weight);
+    return true;
+}
 
-    auto& destNeighbors = adjList[dest];
-    for (auto it = destNeighbors.begin(); it != destNeighbors.end(); ++it) {
-        if (it->first == src) {
-            destNeighbors.erase(it);
-            removed = true;
-            break;
-        }
+template <typename Weight>
+bool BasicGraph<Weight>::removeEdge(const string& src, const string& dest) {
+    auto srcIt = adjList.find(src);
+    auto destIt = adjList.find(dest);
+    if (srcIt == adjList.end() || destIt == adjList.end()) {
+        cerr << "One or both vertices not found.\n";
+        return false;
+    }
+    auto edgeIt = srcIt->second.find(dest);
+    bool removed = (edgeIt != srcIt->second.end());
+    if (removed) {
+        Weight oldWeight = edgeIt->second;
+        srcIt->second.erase(edgeIt);
+        destIt->second.erase(src);
+        markEdited();
+        invalidateCachesForEdge(src, dest, oldWeight, UNREACHABLE);
+        repairWatchedTrees(src, dest, oldWeight, UNREACHABLE);
     }
 
     if (!removed) {
@@ -78,28 +186,30 @@ bool Graph::removeEdge(const string& src, const string& dest) {
     return removed;
 }
 
-bool Graph::updateEdge(const string& src, const string& dest, int newWeight) {
-    if (adjList.find(src) == adjList.end() || adjList.find(dest) == adjList.end()) {
+template <typename Weight>
+bool BasicGraph<Weight>::updateEdge(const string& src, const string& dest, Weight newWeight) {
+    if (!checkWeight(newWeight)) return false;
+    auto srcIt = adjList.find(src);
+    auto destIt = adjList.find(dest);
+    if (srcIt == adjList.end() || destIt == adjList.end()) {
         cerr << "One or both vertices not found.\n";
         return false;
     }
 
-    bool updated = false;
-
-    for (auto& p : adjList[src]) {
-        if (p.first == dest) {
-            p.second = newWeight;
-            updated = true;
-            break;
-        }
-    }
-
-    for (auto& p : adjList[dest]) {
-        if (p.first == src) {
-            p.second = newWeight;
-            updated = true;
-            break;
+    auto edgeIt = srcIt->second.find(dest);
+    bool updated = (edgeIt != srcIt->second.end());
+    if (updated) {
+        Weight oldWeight = edgeIt->second;
+        edgeIt->second = newWeight;
+        destIt->second[src] = newWeight;
+        // Same topology, so the compiled snapshot can usually be patched in place
+        if (patchCompiledWeight(src, dest, newWeight)) {
+            hierarchyStale = true;
+        } else {
+            markEdited();
         }
+        invalidateCachesForEdge(src, dest, oldWeight, newWeight);
+        repairWatchedTrees(src, dest, oldWeight, newWeight);
     }
 
     if (!updated) {
@@ -109,11 +219,82 @@ bool Graph::updateEdge(const string& src, const string& dest, int newWeight) {
     return updated;
 }
 
-void Graph::printGraph() const {
+template <typename Weight>
+size_t BasicGraph<Weight>::applyEdits(const vector<GraphEdit>& edits) {
+    size_t applied = 0;
+    size_t i = 0;
+    while (i < edits.size()) {
+        // Consecutive vertex removals are grouped into one removeVertices pass
+        if (edits[i].kind == GraphEdit::RemoveVertex) {
+            vector<string> labels;
+            for (; i < edits.size() && edits[i].kind == GraphEdit::RemoveVertex; ++i) {
+                labels.push_back(edits[i].src);
+            }
+            applied += removeVertices(labels);
+            continue;
+        }
+        const GraphEdit& edit = edits[i++];
+        bool ok = false;
+        switch (edit.kind) {
+            case GraphEdit::AddVertex:
+                ok = addVertex(edit.src);
+                break;
+            case GraphEdit::AddEdge:
+                ok = addEdge(edit.src, edit.dest, edit.weight);
+                break;
+            case GraphEdit::RemoveEdge:
+                ok = removeEdge(edit.src, edit.dest);
+                break;
+            case GraphEdit::UpdateEdge:
+                ok = updateEdge(edit.src, edit.dest, edit.weight);
+                break;
+            case GraphEdit::RemoveVertex:
+                break;
+        }
+        if (ok) applied++;
+    }
+    return applied;
+}
+
+template <typename Weight>
+void BasicGraph<Weight>::markEdited() {
+    compiledDirty = true;
+    hierarchyStale = true;
+}
+
+template <typename Weight>
+bool BasicGraph<Weight>::patchCompiledWeight(const string& u, const string& v, Weight newWeight) {
+    if (compiledDirty) return false;
+    auto uIt = compiled.ids.find(u);
+    auto vIt = compiled.ids.find(v);
+    if (uIt == compiled.ids.end() || vIt == compiled.ids.end()) return false;
+    uint32_t a = uIt->second;
+    uint32_t b = vIt->second;
+    for (uint32_t e = compiled.offsets[a]; e < compiled.offsets[a + 1]; ++e) {
+        if (compiled.neighbors[e] == b) compiled.weights[e] = newWeight;
+    }
+    for (uint32_t e = compiled.offsets[b]; e < compiled.offsets[b + 1]; ++e) {
+        if (compiled.neighbors[e] == a) compiled.weights[e] = newWeight;
+    }
+    // Only ever raised here, so it stays an upper bound until the next compile
+    compiled.maxWeight = max(compiled.maxWeight, newWeight);
+    // A shorter edge may undercut the A* scale; a longer one keeps it admissible
+    if (compiled.hasCoords) {
+        double len = hypot(compiled.xs[a] - compiled.xs[b], compiled.ys[a] - compiled.ys[b]);
+        if (len > 0.0 && newWeight < compiled.heuristicScale * len) {
+            compiled.heuristicScale = (newWeight / len) * (1.0 - 1e-9);
+        }
+    }
+    return true;
+}
+
+template <typename Weight>
+void BasicGraph<Weight>::printGraph() const {
     cout << "Graph vertices and their edges:\n";
     for (const auto& kv : adjList) {
         const string& vertex = kv.first;
-        const auto& neighbors = kv.second;
+        // Neighbors are hashed; list them in label order for a stable printout
+        map<string, Weight> neighbors(kv.second.begin(), kv.second.end());
         cout << "  " << vertex << ":";
         for (const auto& edge : neighbors) {
             cout << " -> [" << edge.first << ", w=" << edge.second << "]";
@@ -122,69 +303,1257 @@ void Graph::printGraph() const {
     }
 }
 
-bool Graph::findShortestPath(const string& start, const string& end,
-                             vector<string>& path, int& distance) const {
-    if (adjList.find(start) == adjList.end() || adjList.find(end) == adjList.end()) {
+template <typename Weight>
+void BasicGraph<Weight>::compile() const {
+    CompiledGraph fresh;
+    size_t n = adjList.size();
+    fresh.labels.reserve(n);
+    fresh.ids.reserve(n);
+    // Intern labels in map order so ids are stable for an unchanged vertex set
+    for (const auto& kv : adjList) {
+        fresh.ids.emplace(kv.first, static_cast<uint32_t>(fresh.labels.size()));
+        fresh.labels.push_back(kv.first);
+    }
+    // Build the CSR rows: offsets first, then the flat neighbor/weight arrays
+    fresh.offsets.reserve(n + 1);
+    fresh.offsets.push_back(0);
+    for (const auto& kv : adjList) {
+        fresh.offsets.push_back(fresh.offsets.back() + static_cast<uint32_t>(kv.second.size()));
+    }
+    fresh.neighbors.reserve(fresh.offsets.back());
+    fresh.weights.reserve(fresh.offsets.back());
+    for (const auto& kv : adjList) {
+        for (const auto& edge : kv.second) {
+            fresh.neighbors.push_back(fresh.ids.at(edge.first));
+            fresh.weights.push_back(edge.second);
+            fresh.maxWeight = max(fresh.maxWeight, edge.second);
+        }
+    }
+    // Positions for the A* heuristic (only usable if every vertex has one)
+    fresh.hasCoords = (n > 0 && coords.size() == n);
+    if (fresh.hasCoords) {
+        fresh.xs.reserve(n);
+        fresh.ys.reserve(n);
+        for (const auto& kv : adjList) {
+            const auto& pos = coords.at(kv.first);
+            fresh.xs.push_back(pos.first);
+            fresh.ys.push_back(pos.second);
+        }
+        // Scale the straight-line distance so it never overestimates any edge
+        double scale = numeric_limits<double>::infinity();
+        for (uint32_t u = 0; u < n; ++u) {
+            for (uint32_t e = fresh.offsets[u]; e < fresh.offsets[u + 1]; ++e) {
+                uint32_t v = fresh.neighbors[e];
+                double len = hypot(fresh.xs[u] - fresh.xs[v], fresh.ys[u] - fresh.ys[v]);
+                if (len > 0.0) {
+                    scale = min(scale, fresh.weights[e] / len);
+                }
+            }
+        }
+        // Shave off a little so floating-point rounding cannot make it inadmissible
+        fresh.heuristicScale = isinf(scale) ? 0.0 : scale * (1.0 - 1e-9);
+    }
+    compiled = std::move(fresh);
+    compiledDirty = false;
+}
+
+template <typename Weight>
+const typename BasicGraph<Weight>::CompiledGraph&
+BasicGraph<Weight>::compiledView() const {
+    if (compiledDirty) {
+        compile();
+    }
+    return compiled;
+}
+
+template <typename Weight>
+const size_t BasicGraph<Weight>::HOT_SOURCE_THRESHOLD = 4;
+template <typename Weight>
+const size_t BasicGraph<Weight>::HOT_TREE_CAPACITY = 8;
+// Keeps the bucket array small while covering typical aisle lengths
+template <typename Weight>
+const int BasicGraph<Weight>::BUCKET_QUEUE_MAX_WEIGHT = 1024;
+
+template <typename Weight>
+template <typename Search>
+typename BasicGraph<Weight>::QueueKind
+BasicGraph<Weight>::withDijkstraQueue(const CompiledGraph& g, SearchScratch& scratch,
+                                      Search search) const {
+    // Dial's buckets cost O(1) per operation but one slot per possible key offset,
+    // so they only pay off while the largest edge weight is a small integer
+    if constexpr (is_integral_v<Weight>) {
+        if (g.maxWeight <= BUCKET_QUEUE_MAX_WEIGHT) {
+            scratch.buckets.reset(g.maxWeight);
+            search(scratch.buckets);
+            return QueueKind::Buckets;
+        }
+    }
+    scratch.indexed.reset(g.labels.size());
+    search(scratch.indexed);
+    return QueueKind::IndexedHeap;
+}
+
+template <typename Weight>
+bool BasicGraph<Weight>::findShortestPath(const string& start, const string& end,
+                                          vector<string>& path, Weight& distance) const {
+    string key = pathCacheKey(start, end);
+    {
+        lock_guard<mutex> guard(cacheLock);
+        auto hit = pathCacheIndex.find(key);
+        if (hit != pathCacheIndex.end()) {
+            pathCache.splice(pathCache.begin(), pathCache, hit->second);
+            path = hit->second->path;
+            distance = hit->second->distance;
+            cacheStats.hits++;
+            return true;
+        }
+    }
+
+    const CompiledGraph& g = compiledView();
+    auto startIt = g.ids.find(start);
+    auto endIt = g.ids.find(end);
+    if (startIt == g.ids.end() || endIt == g.ids.end()) {
         cerr << "Start or end vertex not found.\n";
         return false;
     }
+    uint32_t source = startIt->second;
+    uint32_t target = endIt->second;
+
+    // Answer from the source's cached tree if there is one; otherwise search, and
+    // cache the whole tree once the source has missed often enough to be "hot"
+    vector<uint32_t> idPath;
+    Weight found = UNREACHABLE;
+    bool fromTree = false;
+    bool hot = false;
+    {
+        lock_guard<mutex> guard(cacheLock);
+        auto watchedIt = watchedTrees.find(start);
+        if (watchedIt != watchedTrees.end()) {
+            CachedTree& tree = watchedIt->second;
+            // Vertex additions/removals shift ids; those are rebuilt rather than repaired
+            if (tree.vertexSetVersion != vertexSetVersion) {
+                tree.source = source;
+                tree.vertexSetVersion = vertexSetVersion;
+                shortestPathTree(g, source, tree.dist, tree.prev);
+            }
+            found = tree.dist[target];
+            if (found != UNREACHABLE) {
+                appendTreePath(tree.prev, target, idPath);
+            }
+            fromTree = true;
+            cacheStats.treeHits++;
+        }
+        for (auto it = treeCache.begin(); !fromTree && it != treeCache.end(); ++it) {
+            if (it->source != source || it->vertexSetVersion != vertexSetVersion) continue;
+            treeCache.splice(treeCache.begin(), treeCache, it);
+            found = it->dist[target];
+            if (found != UNREACHABLE) {
+                appendTreePath(it->prev, target, idPath);
+            }
+            fromTree = true;
+            cacheStats.treeHits++;
+            break;
+        }
+        if (!fromTree) {
+            cacheStats.misses++;
+            hot = (++sourceMisses[start] >= HOT_SOURCE_THRESHOLD);
+            if (sourceMisses.size() > 4 * pathCacheCapacity) {
+                sourceMisses.clear();  // keep the heat map bounded
+            }
+        }
+    }
+
+    if (!fromTree && hot) {
+        CachedTree tree;
+        tree.source = source;
+        shortestPathTree(g, source, tree.dist, tree.prev);
+        found = tree.dist[target];
+        if (found != UNREACHABLE) {
+            appendTreePath(tree.prev, target, idPath);
+        }
+        lock_guard<mutex> guard(cacheLock);
+        tree.vertexSetVersion = vertexSetVersion;
+        sourceMisses.erase(start);
+        treeCache.push_front(std::move(tree));
+        if (treeCache.size() > HOT_TREE_CAPACITY) {
+            treeCache.pop_back();
+            cacheStats.evictions++;
+        }
+    } else if (!fromTree) {
+        QueryStats stats;
+        if (!dijkstraSearch(g, source, target, idPath, found, stats)) {
+            found = UNREACHABLE;
+        }
+    }
+    if (found == UNREACHABLE) {
+        return false;
+    }
 
-    map<string, int> dist;
-    map<string, string> prev;
+    path.clear();
+    path.reserve(idPath.size());
+    for (uint32_t id : idPath) {
+        path.push_back(g.labels[id]);
+    }
+    distance = found;
 
-    for (const auto& kv : adjList) {
-        dist[kv.first] = numeric_limits<int>::max();
+    lock_guard<mutex> guard(cacheLock);
+    if (pathCacheCapacity > 0 && pathCacheIndex.find(key) == pathCacheIndex.end()) {
+        pathCache.push_front({start, end, path, distance});
+        pathCacheIndex[key] = pathCache.begin();
+        while (pathCache.size() > pathCacheCapacity) {
+            const CachedPath& oldest = pathCache.back();
+            pathCacheIndex.erase(pathCacheKey(oldest.start, oldest.end));
+            pathCache.pop_back();
+            cacheStats.evictions++;
+        }
     }
-    dist[start] = 0;
+    return true;
+}
+
+template <typename Weight>
+void BasicGraph<Weight>::setPathCacheCapacity(size_t entries) {
+    lock_guard<mutex> guard(cacheLock);
+    pathCacheCapacity = entries;
+    while (pathCache.size() > pathCacheCapacity) {
+        const CachedPath& oldest = pathCache.back();
+        pathCacheIndex.erase(pathCacheKey(oldest.start, oldest.end));
+        pathCache.pop_back();
+        cacheStats.evictions++;
+    }
+}
+
+template <typename Weight>
+void BasicGraph<Weight>::clearPathCache() {
+    lock_guard<mutex> guard(cacheLock);
+    pathCache.clear();
+    pathCacheIndex.clear();
+    treeCache.clear();
+    sourceMisses.clear();
+}
+
+template <typename Weight>
+typename BasicGraph<Weight>::PathCacheStats
+BasicGraph<Weight>::getPathCacheStats() const {
+    lock_guard<mutex> guard(cacheLock);
+    return cacheStats;
+}
 
-    auto comp = [](const pair<int, string>& a, const pair<int, string>& b) {
-        return a.first > b.first;
+template <typename Weight>
+bool BasicGraph<Weight>::treeSurvivesEdgeChange(const CachedTree& tree, uint32_t u, uint32_t v,
+                                                Weight oldWeight, Weight newWeight) const {
+    const Weight INF = UNREACHABLE;
+    if (newWeight > oldWeight) {
+        // Longer or removed: only paths that use the edge get longer
+        return tree.prev[v] != u && tree.prev[u] != v;
+    }
+    // Shorter or new: the tree holds unless the edge now offers a shortcut to an endpoint
+    auto improves = [&](uint32_t from, uint32_t to) {
+        return tree.dist[from] != INF && Traits::add(tree.dist[from], newWeight) < tree.dist[to];
     };
+    return !improves(u, v) && !improves(v, u);
+}
+
+template <typename Weight>
+void BasicGraph<Weight>::invalidateCachesForEdge(const string& u, const string& v,
+                                                 Weight oldWeight, Weight newWeight) {
+    if (newWeight == oldWeight) return;
+    lock_guard<mutex> guard(cacheLock);
+
+    // Ids of the endpoints in the cached trees' id space. Trees built under the current
+    // vertex set share the ids of the compiled snapshot (edge edits keep ids stable).
+    auto uIt = compiled.ids.find(u);
+    auto vIt = compiled.ids.find(v);
+    bool idsKnown = (uIt != compiled.ids.end() && vIt != compiled.ids.end());
+    // Sources whose cached tree survives the change; their cached pairs survive too
+    vector<uint32_t> safeSources;
+    for (auto it = treeCache.begin(); it != treeCache.end(); ) {
+        if (it->vertexSetVersion == vertexSetVersion && idsKnown &&
+            treeSurvivesEdgeChange(*it, uIt->second, vIt->second, oldWeight, newWeight)) {
+            safeSources.push_back(it->source);
+            ++it;
+        } else {
+            it = treeCache.erase(it);
+            cacheStats.invalidations++;
+        }
+    }
+
+    for (auto it = pathCache.begin(); it != pathCache.end(); ) {
+        bool affected;
+        if (newWeight > oldWeight) {
+            // Only a path running along the edge can get longer
+            affected = false;
+            for (size_t i = 0; i + 1 < it->path.size() && !affected; ++i) {
+                affected = (it->path[i] == u && it->path[i + 1] == v) ||
+                           (it->path[i] == v && it->path[i + 1] == u);
+            }
+        } else {
+            // A shorter edge can improve any path unless the start's tree proves otherwise
+            auto startIt = compiled.ids.find(it->start);
+            affected = !(startIt != compiled.ids.end() &&
+                         find(safeSources.begin(), safeSources.end(), startIt->second)
+                             != safeSources.end());
+        }
+        if (affected) {
+            pathCacheIndex.erase(pathCacheKey(it->start, it->end));
+            it = pathCache.erase(it);
+            cacheStats.invalidations++;
+        } else {
+            ++it;
+        }
+    }
+}
 
-    priority_queue<pair<int, string>, vector<pair<int, string>>, decltype(comp)> pq(comp);
-    pq.push({0, start});
+template <typename Weight>
+void BasicGraph<Weight>::invalidateCachesForVertices(const function<bool(const string&)>& removed) {
+    lock_guard<mutex> guard(cacheLock);
+    // Removing vertices shifts the compiled ids, so every cached tree retires
+    vertexSetVersion++;
+    cacheStats.invalidations += treeCache.size();
+    treeCache.clear();
+    for (auto it = pathCache.begin(); it != pathCache.end(); ) {
+        if (any_of(it->path.begin(), it->path.end(), removed)) {
+            pathCacheIndex.erase(pathCacheKey(it->start, it->end));
+            it = pathCache.erase(it);
+            cacheStats.invalidations++;
+        } else {
+            ++it;
+        }
+    }
+    for (auto it = sourceMisses.begin(); it != sourceMisses.end(); ) {
+        it = removed(it->first) ? sourceMisses.erase(it) : next(it);
+    }
+    // A removed watched source stops being watched; the rest rebuild on next use
+    for (auto it = watchedTrees.begin(); it != watchedTrees.end(); ) {
+        it = removed(it->first) ? watchedTrees.erase(it) : next(it);
+    }
+}
 
-    map<string, bool> visited;
+template <typename Weight>
+bool BasicGraph<Weight>::watchSource(const string& source) {
+    const CompiledGraph& g = compiledView();
+    auto it = g.ids.find(source);
+    if (it == g.ids.end()) {
+        cerr << "Vertex '" << source << "' not found.\n";
+        return false;
+    }
+    lock_guard<mutex> guard(cacheLock);
+    CachedTree& tree = watchedTrees[source];
+    tree.source = it->second;
+    tree.vertexSetVersion = vertexSetVersion;
+    shortestPathTree(g, tree.source, tree.dist, tree.prev);
+    return true;
+}
+
+template <typename Weight>
+bool BasicGraph<Weight>::unwatchSource(const string& source) {
+    lock_guard<mutex> guard(cacheLock);
+    if (watchedTrees.erase(source) == 0) {
+        cerr << "Vertex '" << source << "' is not watched.\n";
+        return false;
+    }
+    return true;
+}
+
+template <typename Weight>
+void BasicGraph<Weight>::repairWatchedTrees(const string& u, const string& v,
+                                            Weight oldWeight, Weight newWeight) {
+    if (newWeight == oldWeight || watchedTrees.empty()) return;
+    const CompiledGraph& g = compiledView();
+    auto uIt = g.ids.find(u);
+    auto vIt = g.ids.find(v);
+    if (uIt == g.ids.end() || vIt == g.ids.end()) return;
+
+    lock_guard<mutex> guard(cacheLock);
+    for (auto& entry : watchedTrees) {
+        CachedTree& tree = entry.second;
+        if (tree.vertexSetVersion != vertexSetVersion) continue;  // rebuilt on next use
+        if (newWeight > oldWeight) {
+            repairTreeAfterIncrease(g, tree, uIt->second, vIt->second);
+        } else {
+            repairTreeAfterDecrease(g, tree, uIt->second, vIt->second, newWeight);
+        }
+    }
+}
+
+template <typename Weight>
+void BasicGraph<Weight>::repairTreeAfterIncrease(const CompiledGraph& g, CachedTree& tree,
+                                                 uint32_t u, uint32_t v) const {
+    const Weight INF = UNREACHABLE;
+    vector<Weight>& dist = tree.dist;
+    vector<uint32_t>& prev = tree.prev;
+    // Only the subtree hanging below the edge can get longer
+    uint32_t child;
+    if (prev[v] == u) {
+        child = v;
+    } else if (prev[u] == v) {
+        child = u;
+    } else {
+        return;
+    }
 
+    // Collect that subtree, marking its vertices with INF as we go
+    vector<uint32_t> affected;
+    affected.push_back(child);
+    dist[child] = INF;
+    for (size_t i = 0; i < affected.size(); ++i) {
+        uint32_t x = affected[i];
+        for (uint32_t e = g.offsets[x]; e < g.offsets[x + 1]; ++e) {
+            uint32_t y = g.neighbors[e];
+            if (prev[y] == x && dist[y] != INF) {
+                dist[y] = INF;
+                affected.push_back(y);
+            }
+        }
+    }
+
+    // Seed each affected vertex with its best edge from the unaffected part of the tree
+    typedef pair<Weight, uint32_t> Entry;
+    priority_queue<Entry, vector<Entry>, greater<Entry>> pq;
+    for (uint32_t y : affected) {
+        prev[y] = NO_VERTEX;
+        for (uint32_t e = g.offsets[y]; e < g.offsets[y + 1]; ++e) {
+            uint32_t z = g.neighbors[e];
+            if (dist[z] == INF) continue;
+            Weight candidate = Traits::add(dist[z], g.weights[e]);
+            if (candidate < dist[y]) {
+                dist[y] = candidate;
+                prev[y] = z;
+            }
+        }
+        if (dist[y] != INF) {
+            pq.push({dist[y], y});
+        }
+    }
+
+    // Settle the affected vertices; unaffected distances cannot shrink after an increase
+    while (!pq.empty()) {
+        Weight distX = pq.top().first;
+        uint32_t x = pq.top().second;
+        pq.pop();
+        if (distX > dist[x]) continue;
+        for (uint32_t e = g.offsets[x]; e < g.offsets[x + 1]; ++e) {
+            uint32_t y = g.neighbors[e];
+            Weight candidate = Traits::add(distX, g.weights[e]);
+            if (candidate < dist[y]) {
+                dist[y] = candidate;
+                prev[y] = x;
+                pq.push({candidate, y});
+            }
+        }
+    }
+}
+
+template <typename Weight>
+void BasicGraph<Weight>::repairTreeAfterDecrease(const CompiledGraph& g, CachedTree& tree,
+                                                 uint32_t u, uint32_t v, Weight weight) const {
+    vector<Weight>& dist = tree.dist;
+    vector<uint32_t>& prev = tree.prev;
+    typedef pair<Weight, uint32_t> Entry;
+    priority_queue<Entry, vector<Entry>, greater<Entry>> pq;
+    // The edge may now offer a shortcut into either endpoint
+    uint32_t ends[2][2] = {{u, v}, {v, u}};
+    for (auto& edge : ends) {
+        uint32_t from = edge[0];
+        uint32_t to = edge[1];
+        Weight viaEdge = Traits::add(dist[from], weight);
+        if (viaEdge < dist[to]) {
+            dist[to] = viaEdge;
+            prev[to] = from;
+            pq.push({dist[to], to});
+        }
+    }
+    // Propagate the improvement only as far as distances keep dropping
     while (!pq.empty()) {
-        pair<int, string> top = pq.top();
+        Weight distX = pq.top().first;
+        uint32_t x = pq.top().second;
         pq.pop();
+        if (distX > dist[x]) continue;
+        for (uint32_t e = g.offsets[x]; e < g.offsets[x + 1]; ++e) {
+            uint32_t y = g.neighbors[e];
+            Weight candidate = Traits::add(distX, g.weights[e]);
+            if (candidate < dist[y]) {
+                dist[y] = candidate;
+                prev[y] = x;
+                pq.push({candidate, y});
+            }
+        }
+    }
+}
+
+template <typename Weight>
+bool BasicGraph<Weight>::findShortestPath(const string& start, const string& end,
+                                          vector<string>& path, Weight& distance,
+                                          QueryMode mode, QueryStats& stats) const {
+    const CompiledGraph& g = compiledView();
+    auto startIt = g.ids.find(start);
+    auto endIt = g.ids.find(end);
+    if (startIt == g.ids.end() || endIt == g.ids.end()) {
+        cerr << "Start or end vertex not found.\n";
+        return false;
+    }
+    uint32_t source = startIt->second;
+    uint32_t target = endIt->second;
+
+    stats = QueryStats();
+    vector<uint32_t> idPath;
+    Weight found = 0;
+    bool ok = false;
+    switch (mode) {
+        case QueryMode::Dijkstra:
+            ok = dijkstraSearch(g, source, target, idPath, found, stats);
+            break;
+        case QueryMode::Bidirectional:
+            ok = bidirectionalSearch(g, source, target, idPath, found, stats);
+            break;
+        case QueryMode::AStar:
+            ok = aStarSearch(g, source, target, idPath, found, stats);
+            break;
+        case QueryMode::ContractionHierarchy:
+            ok = hierarchySearch(g, source, target, idPath, found, stats);
+            break;
+    }
+    if (!ok) {
+        return false;
+    }
+
+    path.clear();
+    path.reserve(idPath.size());
+    for (uint32_t id : idPath) {
+        path.push_back(g.labels[id]);
+    }
+    distance = found;
+    return true;
+}
+
+template <typename Weight>
+bool BasicGraph<Weight>::dijkstraSearch(const CompiledGraph& g, uint32_t source, uint32_t target,
+                                        vector<uint32_t>& idPath, Weight& distance,
+                                        QueryStats& stats) const {
+    const Weight INF = UNREACHABLE;
+    vector<Weight> dist(g.labels.size(), INF);
+    vector<uint32_t> prev(g.labels.size(), NO_VERTEX);
+    dist[source] = 0;
+
+    stats.queue = withDijkstraQueue(g, threadScratch(), [&](auto& queue) {
+        queue.push(source, 0);
+        stats.settledVertices += runDijkstra(g, queue, dist,
+            [target](uint32_t u) { return u == target; },
+            [&prev](uint32_t v, uint32_t u) { prev[v] = u; });
+    });
 
-        int distU = top.first;
-        string u = top.second;
+    if (dist[target] == INF) {
+        return false;
+    }
+    idPath.clear();
+    appendTreePath(prev, target, idPath);
+    distance = dist[target];
+    return true;
+}
+
+template <typename Weight>
+bool BasicGraph<Weight>::bidirectionalSearch(const CompiledGraph& g,
+                                             uint32_t source, uint32_t target,
+                                             vector<uint32_t>& idPath, Weight& distance,
+                                             QueryStats& stats) const {
+    const Weight INF = UNREACHABLE;
+    size_t n = g.labels.size();
+    // Index 0 is the forward search from source, index 1 the backward search from target.
+    // Edges are undirected, so both directions scan the same CSR rows.
+    vector<Weight> dist[2] = {vector<Weight>(n, INF), vector<Weight>(n, INF)};
+    vector<uint32_t> prev[2] = {vector<uint32_t>(n, NO_VERTEX), vector<uint32_t>(n, NO_VERTEX)};
+    vector<char> settled[2] = {vector<char>(n, 0), vector<char>(n, 0)};
+    typedef pair<Weight, uint32_t> Entry;
+    priority_queue<Entry, vector<Entry>, greater<Entry>> pq[2];
+
+    dist[0][source] = 0;
+    dist[1][target] = 0;
+    pq[0].push({0, source});
+    pq[1].push({0, target});
+
+    Weight best = (source == target) ? 0 : INF;  // shortest source-target length seen so far
+    uint32_t meet = (source == target) ? source : NO_VERTEX;
+
+    while (!pq[0].empty() && !pq[1].empty()) {
+        // Once the two frontier minimums together reach 'best', no shorter path remains
+        if (best != INF && Traits::add(pq[0].top().first, pq[1].top().first) >= best) break;
+
+        // Expand the side with the smaller frontier
+        int side = (pq[0].top().first <= pq[1].top().first) ? 0 : 1;
+        Weight distU = pq[side].top().first;
+        uint32_t u = pq[side].top().second;
+        pq[side].pop();
+        if (settled[side][u]) continue;
+        settled[side][u] = 1;
+        stats.settledVertices++;
+
+        for (uint32_t e = g.offsets[u]; e < g.offsets[u + 1]; ++e) {
+            uint32_t v = g.neighbors[e];
+            Weight candidate = Traits::add(distU, g.weights[e]);
+            if (candidate < dist[side][v]) {
+                dist[side][v] = candidate;
+                prev[side][v] = u;
+                pq[side].push({candidate, v});
+            }
+            // A vertex reached from both sides closes a candidate path
+            Weight through = Traits::add(dist[side][v], dist[1 - side][v]);
+            if (through < best) {
+                best = through;
+                meet = v;
+            }
+        }
+    }
+
+    if (best == INF) {
+        return false;
+    }
+    // Forward half ends at the meeting vertex; the backward half walks on to target
+    idPath.clear();
+    appendTreePath(prev[0], meet, idPath);
+    for (uint32_t cur = prev[1][meet]; cur != NO_VERTEX; cur = prev[1][cur]) {
+        idPath.push_back(cur);
+    }
+    distance = best;
+    return true;
+}
 
-        if (visited[u]) continue;
-        visited[u] = true;
+template <typename Weight>
+bool BasicGraph<Weight>::aStarSearch(const CompiledGraph& g, uint32_t source, uint32_t target,
+                                     vector<uint32_t>& idPath, Weight& distance,
+                                     QueryStats& stats) const {
+    if (!g.hasCoords || g.heuristicScale <= 0.0) {
+        // Without positions the heuristic is zero and A* is exactly Dijkstra
+        return dijkstraSearch(g, source, target, idPath, distance, stats);
+    }
+    const Weight INF = UNREACHABLE;
+    size_t n = g.labels.size();
+    vector<Weight> dist(n, INF);
+    vector<uint32_t> prev(n, NO_VERTEX);
+    vector<char> settled(n, 0);
+    double tx = g.xs[target];
+    double ty = g.ys[target];
+    auto heuristic = [&](uint32_t v) {
+        return g.heuristicScale * hypot(g.xs[v] - tx, g.ys[v] - ty);
+    };
 
-        if (u == end) break;
+    // Min-heap ordered by f = g + h; the heuristic is consistent, so a vertex is
+    // final the first time it is popped
+    typedef pair<double, uint32_t> Entry;
+    priority_queue<Entry, vector<Entry>, greater<Entry>> pq;
+    dist[source] = 0;
+    pq.push({heuristic(source), source});
 
-        const auto& neighbors = adjList.at(u);
-        for (size_t i = 0; i < neighbors.size(); ++i) {
-            string v = neighbors[i].first;
-            int w = neighbors[i].second;
+    while (!pq.empty()) {
+        uint32_t u = pq.top().second;
+        pq.pop();
+        if (settled[u]) continue;
+        settled[u] = 1;
+        stats.settledVertices++;
+        if (u == target) break;
 
-            if (visited[v]) continue;
-            if (distU + w < dist[v]) {
-                dist[v] = distU + w;
+        Weight distU = dist[u];
+        for (uint32_t e = g.offsets[u]; e < g.offsets[u + 1]; ++e) {
+            uint32_t v = g.neighbors[e];
+            if (settled[v]) continue;
+            Weight candidate = Traits::add(distU, g.weights[e]);
+            if (candidate < dist[v]) {
+                dist[v] = candidate;
                 prev[v] = u;
-                pq.push({dist[v], v});
+                pq.push({candidate + heuristic(v), v});
+            }
+        }
+    }
+
+    if (dist[target] == INF) {
+        return false;
+    }
+    idPath.clear();
+    appendTreePath(prev, target, idPath);
+    distance = dist[target];
+    return true;
+}
+
+template <typename Weight>
+size_t BasicGraph<Weight>::buildContractionHierarchy() {
+    const CompiledGraph& g = compiledView();
+    const Weight INF = UNREACHABLE;
+    // Witness searches give up after this many settled vertices and keep the shortcut,
+    // which is always safe (an unnecessary shortcut only costs a little query time)
+    const size_t WITNESS_SETTLE_LIMIT = 500;
+    uint32_t n = static_cast<uint32_t>(g.labels.size());
+
+    // Remaining (not yet contracted) graph: neighbor -> (weight, middle vertex).
+    // Parallel edges collapse to the lightest one and self-loops are dropped.
+    vector<unordered_map<uint32_t, pair<Weight, uint32_t>>> remaining(n);
+    for (uint32_t u = 0; u < n; ++u) {
+        for (uint32_t e = g.offsets[u]; e < g.offsets[u + 1]; ++e) {
+            uint32_t v = g.neighbors[e];
+            if (v == u) continue;
+            auto it = remaining[u].find(v);
+            if (it == remaining[u].end() || g.weights[e] < it->second.first) {
+                remaining[u][v] = {g.weights[e], NO_VERTEX};
+            }
+        }
+    }
+
+    vector<char> contracted(n, 0);
+    vector<int> contractedNeighbors(n, 0);
+    vector<Weight> witnessDist(n, INF);
+    vector<uint32_t> touched;
+
+    // Collect the shortcuts (u, w, length) needed if v were contracted now: one for
+    // every neighbor pair whose path through v has no equally short witness around v.
+    struct Shortcut { uint32_t from, to; Weight length; };
+    auto findShortcuts = [&](uint32_t v, vector<Shortcut>& out) {
+        out.clear();
+        const auto& around = remaining[v];
+        for (const auto& first : around) {
+            uint32_t u = first.first;
+            // Each unordered pair is checked once, from its smaller id
+            Weight maxLength = -1;
+            for (const auto& second : around) {
+                if (second.first > u) {
+                    maxLength = max(maxLength,
+                                    Traits::add(first.second.first, second.second.first));
+                }
+            }
+            if (maxLength < 0) continue;
+            // Bounded Dijkstra from u in the remaining graph, never passing through v
+            typedef pair<Weight, uint32_t> Entry;
+            priority_queue<Entry, vector<Entry>, greater<Entry>> pq;
+            witnessDist[u] = 0;
+            touched.push_back(u);
+            pq.push({0, u});
+            size_t settledCount = 0;
+            while (!pq.empty() && settledCount < WITNESS_SETTLE_LIMIT) {
+                Weight d = pq.top().first;
+                uint32_t x = pq.top().second;
+                pq.pop();
+                if (d > witnessDist[x]) continue;
+                if (d > maxLength) break;
+                settledCount++;
+                for (const auto& edge : remaining[x]) {
+                    uint32_t y = edge.first;
+                    if (y == v) continue;
+                    Weight candidate = Traits::add(d, edge.second.first);
+                    if (candidate < witnessDist[y]) {
+                        if (witnessDist[y] == INF) touched.push_back(y);
+                        witnessDist[y] = candidate;
+                        pq.push({candidate, y});
+                    }
+                }
+            }
+            for (const auto& second : around) {
+                uint32_t w = second.first;
+                if (w <= u) continue;
+                Weight viaV = Traits::add(first.second.first, second.second.first);
+                if (witnessDist[w] > viaV) {
+                    out.push_back({u, w, viaV});
+                }
+            }
+            for (uint32_t x : touched) witnessDist[x] = INF;
+            touched.clear();
+        }
+    };
+
+    // Edge difference plus contracted-neighbor count: contract cheap, spread-out vertices first
+    vector<Shortcut> shortcuts;
+    auto priority = [&](uint32_t v) {
+        findShortcuts(v, shortcuts);
+        return static_cast<int>(shortcuts.size()) - static_cast<int>(remaining[v].size())
+               + contractedNeighbors[v];
+    };
+
+    typedef pair<int, uint32_t> Entry;
+    priority_queue<Entry, vector<Entry>, greater<Entry>> order;
+    for (uint32_t v = 0; v < n; ++v) {
+        order.push({priority(v), v});
+    }
+
+    ContractionHierarchy fresh;
+    fresh.rank.assign(n, 0);
+    // Upward edges of each vertex, captured at the moment it is contracted
+    vector<vector<pair<uint32_t, pair<Weight, uint32_t>>>> upward(n);
+    uint32_t nextRank = 0;
+    while (!order.empty()) {
+        uint32_t v = order.top().second;
+        order.pop();
+        if (contracted[v]) continue;
+        // Lazy update: re-evaluate and defer v if it is no longer the cheapest
+        int current = priority(v);
+        if (!order.empty() && current > order.top().first) {
+            order.push({current, v});
+            continue;
+        }
+
+        fresh.rank[v] = nextRank++;
+        contracted[v] = 1;
+        upward[v].assign(remaining[v].begin(), remaining[v].end());
+        for (const auto& edge : remaining[v]) {
+            remaining[edge.first].erase(v);
+            contractedNeighbors[edge.first]++;
+        }
+        for (const Shortcut& sc : shortcuts) {
+            auto it = remaining[sc.from].find(sc.to);
+            if (it == remaining[sc.from].end() || sc.length < it->second.first) {
+                remaining[sc.from][sc.to] = {sc.length, v};
+                remaining[sc.to][sc.from] = {sc.length, v};
+                fresh.shortcutCount++;
+            }
+        }
+        remaining[v].clear();
+    }
+
+    // Flatten the upward edges into CSR arrays
+    fresh.upOffsets.reserve(n + 1);
+    fresh.upOffsets.push_back(0);
+    for (uint32_t v = 0; v < n; ++v) {
+        for (const auto& edge : upward[v]) {
+            fresh.upTargets.push_back(edge.first);
+            fresh.upWeights.push_back(edge.second.first);
+            fresh.upMiddle.push_back(edge.second.second);
+        }
+        fresh.upOffsets.push_back(static_cast<uint32_t>(fresh.upTargets.size()));
+    }
+
+    hierarchy = std::move(fresh);
+    hierarchyStale = false;
+    return hierarchy.shortcutCount;
+}
+
+template <typename Weight>
+bool BasicGraph<Weight>::hasContractionHierarchy() const {
+    return !hierarchyStale;
+}
+
+template <typename Weight>
+bool BasicGraph<Weight>::hierarchySearch(const CompiledGraph& g, uint32_t source, uint32_t target,
+                                         vector<uint32_t>& idPath, Weight& distance,
+                                         QueryStats& stats) const {
+    if (hierarchyStale) {
+        return dijkstraSearch(g, source, target, idPath, distance, stats);
+    }
+    const ContractionHierarchy& ch = hierarchy;
+    const Weight INF = UNREACHABLE;
+    size_t n = g.labels.size();
+    // Both searches only climb to higher ranks; they meet at the top of the path.
+    // prevEdge records the upward edge used to reach a vertex, for unpacking.
+    vector<Weight> dist[2] = {vector<Weight>(n, INF), vector<Weight>(n, INF)};
+    vector<uint32_t> prev[2] = {vector<uint32_t>(n, NO_VERTEX), vector<uint32_t>(n, NO_VERTEX)};
+    vector<uint32_t> prevEdge[2] = {vector<uint32_t>(n, NO_VERTEX), vector<uint32_t>(n, NO_VERTEX)};
+    typedef pair<Weight, uint32_t> Entry;
+    priority_queue<Entry, vector<Entry>, greater<Entry>> pq[2];
+
+    dist[0][source] = 0;
+    dist[1][target] = 0;
+    pq[0].push({0, source});
+    pq[1].push({0, target});
+    Weight best = INF;
+    uint32_t meet = NO_VERTEX;
+
+    while (!pq[0].empty() || !pq[1].empty()) {
+        for (int side = 0; side < 2; ++side) {
+            if (pq[side].empty()) continue;
+            Weight distU = pq[side].top().first;
+            uint32_t u = pq[side].top().second;
+            pq[side].pop();
+            if (distU > dist[side][u]) continue;
+            // This side cannot improve on the best meeting point any more
+            if (distU >= best) {
+                pq[side] = priority_queue<Entry, vector<Entry>, greater<Entry>>();
+                continue;
+            }
+            stats.settledVertices++;
+            Weight through = Traits::add(distU, dist[1 - side][u]);
+            if (through < best) {
+                best = through;
+                meet = u;
+            }
+            for (uint32_t e = ch.upOffsets[u]; e < ch.upOffsets[u + 1]; ++e) {
+                uint32_t v = ch.upTargets[e];
+                Weight candidate = Traits::add(distU, ch.upWeights[e]);
+                if (candidate < dist[side][v]) {
+                    dist[side][v] = candidate;
+                    prev[side][v] = u;
+                    prevEdge[side][v] = e;
+                    pq[side].push({candidate, v});
+                }
             }
         }
     }
 
-    if (dist[end] == numeric_limits<int>::max()) {
+    if (best == INF) {
         return false;
     }
 
+    // Upward chain source -> meet, listed from the meeting vertex down
+    vector<uint32_t> chain;
+    for (uint32_t cur = meet; cur != source; cur = prev[0][cur]) {
+        chain.push_back(cur);
+    }
+    idPath.clear();
+    idPath.push_back(source);
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+        uint32_t to = *it;
+        unpackHierarchyEdge(prev[0][to], to, ch.upMiddle[prevEdge[0][to]], idPath);
+    }
+    // Downward half: the backward search's upward edges, walked in reverse
+    for (uint32_t cur = meet; cur != target; cur = prev[1][cur]) {
+        unpackHierarchyEdge(cur, prev[1][cur], ch.upMiddle[prevEdge[1][cur]], idPath);
+    }
+    distance = best;
+    return true;
+}
+
+template <typename Weight>
+void BasicGraph<Weight>::unpackHierarchyEdge(uint32_t from, uint32_t to, uint32_t middle,
+                                             vector<uint32_t>& idPath) const {
+    const ContractionHierarchy& ch = hierarchy;
+    // Middle of the upward edge stored at 'low' (the lower-ranked end) towards 'high'
+    auto middleOf = [&](uint32_t low, uint32_t high) {
+        for (uint32_t e = ch.upOffsets[low]; e < ch.upOffsets[low + 1]; ++e) {
+            if (ch.upTargets[e] == high) return ch.upMiddle[e];
+        }
+        return NO_VERTEX;
+    };
+    // Explicit stack of (from, to, middle) segments, expanded left to right
+    struct Segment { uint32_t from, to, middle; };
+    vector<Segment> stack;
+    stack.push_back({from, to, middle});
+    while (!stack.empty()) {
+        Segment seg = stack.back();
+        stack.pop_back();
+        if (seg.middle == NO_VERTEX) {
+            idPath.push_back(seg.to);
+            continue;
+        }
+        // A shortcut from-to bypasses 'middle', which is ranked below both ends
+        stack.push_back({seg.middle, seg.to, middleOf(seg.middle, seg.to)});
+        stack.push_back({seg.from, seg.middle, middleOf(seg.middle, seg.from)});
+    }
+}
+
+template <typename Weight>
+typename BasicGraph<Weight>::QueueKind
+BasicGraph<Weight>::shortestPathTree(const CompiledGraph& g, uint32_t source,
+                                     vector<Weight>& dist, vector<uint32_t>& prev,
+                                     const vector<char>* targets, size_t targetCount) const {
+    dist.assign(g.labels.size(), UNREACHABLE);
+    prev.assign(g.labels.size(), NO_VERTEX);
+    dist[source] = 0;
+
+    return withDijkstraQueue(g, threadScratch(), [&](auto& queue) {
+        queue.push(source, 0);
+        runDijkstra(g, queue, dist,
+            [&](uint32_t u) { return targets && (*targets)[u] && --targetCount == 0; },
+            [&prev](uint32_t v, uint32_t u) { prev[v] = u; });
+    });
+}
+
+template <typename Weight>
+bool BasicGraph<Weight>::findShoppingRoute(const string& start, const string& end,
+                                           const vector<string>& stops, vector<string>& stopOrder,
+                                           vector<string>& path, Weight& distance) const {
+    // Stop lists up to this size are ordered exactly (O(2^k * k^2) time)
+    const size_t HELD_KARP_MAX_STOPS = 10;
+
+    const CompiledGraph& g = compiledView();
+    auto startIt = g.ids.find(start);
+    auto endIt = g.ids.find(end);
+    if (startIt == g.ids.end() || endIt == g.ids.end()) {
+        cerr << "Start or end vertex not found.\n";
+        return false;
+    }
+
+    // Terminals: start, the distinct stops, then end
+    vector<uint32_t> terminals;
+    terminals.push_back(startIt->second);
+    for (const string& stop : stops) {
+        auto it = g.ids.find(stop);
+        if (it == g.ids.end()) {
+            cerr << "Stop '" << stop << "' not found.\n";
+            return false;
+        }
+        if (it->second == startIt->second || it->second == endIt->second) continue;
+        if (find(terminals.begin(), terminals.end(), it->second) != terminals.end()) continue;
+        terminals.push_back(it->second);
+    }
+    terminals.push_back(endIt->second);
+    size_t k = terminals.size();
+    size_t m = k - 2;  // number of stops to order
+
+    // One shortest-path tree per terminal except the end: edges are undirected, so
+    // distances to the end come from the other trees, and no leg starts there. Each
+    // search stops once every terminal is settled. The compiled view is already
+    // built, so the pool's threads only read shared state.
+    vector<char> isTerminal(g.labels.size(), 0);
+    for (uint32_t id : terminals) {
+        isTerminal[id] = 1;
+    }
+    size_t sources = k - 1;
+    size_t distinctTerminals = k - (terminals.front() == terminals.back() ? 1 : 0);
+    vector<vector<Weight>> dist(k);
+    vector<vector<uint32_t>> prev(k);
+    ThreadPool::shared().parallelFor(sources, [&](size_t i) {
+        shortestPathTree(g, terminals[i], dist[i], prev[i], &isTerminal, distinctTerminals);
+    });
+
+    // Terminal-to-terminal distance matrix; sums of its entries saturate (Traits::add)
+    vector<vector<Weight>> D(k, vector<Weight>(k, 0));
+    for (size_t i = 0; i < k; ++i) {
+        for (size_t j = 0; j < k; ++j) {
+            if (i == j) continue;
+            Weight d = (i < sources) ? dist[i][terminals[j]] : dist[j][terminals[i]];
+            if (d == UNREACHABLE) {
+                cerr << "No path between '" << g.labels[terminals[i]] << "' and '"
+                     << g.labels[terminals[j]] << "'.\n";
+                return false;
+            }
+            D[i][j] = d;
+        }
+    }
+
+    // Visiting order as terminal indices 1..m (0 is start, k-1 is end)
+    vector<size_t> order;
+    if (m <= HELD_KARP_MAX_STOPS) {
+        // Held-Karp: best[mask][last] = shortest walk from start through the stops in
+        // mask ending at stop 'last'
+        const Weight UNSET = UNREACHABLE;
+        size_t full = (size_t(1) << m) - 1;
+        vector<vector<Weight>> best(full + 1, vector<Weight>(m, UNSET));
+        vector<vector<size_t>> from(full + 1, vector<size_t>(m, m));
+        for (size_t i = 0; i < m; ++i) {
+            best[size_t(1) << i][i] = D[0][i + 1];
+        }
+        for (size_t mask = 1; mask <= full; ++mask) {
+            for (size_t last = 0; last < m; ++last) {
+                if (!(mask & (size_t(1) << last)) || best[mask][last] == UNSET) continue;
+                for (size_t next = 0; next < m; ++next) {
+                    if (mask & (size_t(1) << next)) continue;
+                    size_t grown = mask | (size_t(1) << next);
+                    Weight cost = Traits::add(best[mask][last], D[last + 1][next + 1]);
+                    if (cost < best[grown][next]) {
+                        best[grown][next] = cost;
+                        from[grown][next] = last;
+                    }
+                }
+            }
+        }
+        if (m > 0) {
+            size_t last = 0;
+            for (size_t i = 1; i < m; ++i) {
+                if (Traits::add(best[full][i], D[i + 1][k - 1]) <
+                    Traits::add(best[full][last], D[last + 1][k - 1])) {
+                    last = i;
+                }
+            }
+            for (size_t mask = full; mask != 0; ) {
+                order.push_back(last + 1);
+                size_t before = from[mask][last];
+                mask &= ~(size_t(1) << last);
+                last = before;
+            }
+            reverse(order.begin(), order.end());
+        }
+    } else {
+        // Nearest-neighbour construction
+        vector<char> used(k, 0);
+        size_t cur = 0;
+        for (size_t step = 0; step < m; ++step) {
+            size_t pick = 0;
+            for (size_t i = 1; i <= m; ++i) {
+                if (!used[i] && (pick == 0 || D[cur][i] < D[cur][pick])) pick = i;
+            }
+            used[pick] = 1;
+            order.push_back(pick);
+            cur = pick;
+        }
+
+        // Local search on the full tour [start, order..., end] with fixed endpoints
+        vector<size_t> tour;
+        tour.push_back(0);
+        tour.insert(tour.end(), order.begin(), order.end());
+        tour.push_back(k - 1);
+        bool improved = true;
+        while (improved) {
+            improved = false;
+            // 2-opt: reverse tour[i..j]
+            for (size_t i = 1; i + 1 < tour.size(); ++i) {
+                for (size_t j = i + 1; j + 1 < tour.size(); ++j) {
+                    Weight after = Traits::add(D[tour[i - 1]][tour[j]], D[tour[i]][tour[j + 1]]);
+                    Weight before = Traits::add(D[tour[i - 1]][tour[i]], D[tour[j]][tour[j + 1]]);
+                    if (after < before) {
+                        reverse(tour.begin() + i, tour.begin() + j + 1);
+                        improved = true;
+                    }
+                }
+            }
+            // Or-opt: move a run of 1-3 stops to another gap in the tour
+            for (size_t len = 1; len <= 3; ++len) {
+                for (size_t i = 1; i + len < tour.size(); ++i) {
+                    size_t first = tour[i];
+                    size_t last = tour[i + len - 1];
+                    // Moving the run pays off if the closed gap plus the two new edges
+                    // are shorter than the two old edges plus the opened gap
+                    Weight cut = Traits::add(D[tour[i - 1]][first], D[last][tour[i + len]]);
+                    Weight bridge = D[tour[i - 1]][tour[i + len]];
+                    for (size_t p = 0; p + 1 < tour.size(); ++p) {
+                        if (p + 1 >= i && p < i + len) continue;  // gap inside or beside the run
+                        Weight join = Traits::add(D[tour[p]][first], D[last][tour[p + 1]]);
+                        if (Traits::add(join, bridge) < Traits::add(cut, D[tour[p]][tour[p + 1]])) {
+                            vector<size_t> run(tour.begin() + i, tour.begin() + i + len);
+                            tour.erase(tour.begin() + i, tour.begin() + i + len);
+                            size_t at = (p < i) ? p + 1 : p + 1 - len;
+                            tour.insert(tour.begin() + at, run.begin(), run.end());
+                            improved = true;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+        order.assign(tour.begin() + 1, tour.end() - 1);
+    }
+
+    // Stitch the legs together from the per-terminal trees
+    stopOrder.clear();
     path.clear();
-    string cur = end;
-    while (cur != start) {
-        path.push_back(cur);
-        cur = prev[cur];
+    path.push_back(g.labels[terminals[0]]);
+    Weight total = 0;
+    size_t from = 0;
+    order.push_back(k - 1);
+    for (size_t to : order) {
+        if (to != k - 1) {
+            stopOrder.push_back(g.labels[terminals[to]]);
+        }
+        vector<uint32_t> leg;
+        appendTreePath(prev[from], terminals[to], leg);
+        for (size_t i = 1; i < leg.size(); ++i) {
+            path.push_back(g.labels[leg[i]]);
+        }
+        total = Traits::add(total, D[from][to]);
+        from = to;
     }
-    path.push_back(start);
-    reverse(path.begin(), path.end());
+    if (total == UNREACHABLE) {
+        cerr << "Route length exceeds the distance range.\n";
+        return false;
+    }
+    distance = total;
+    return true;
+}
+
+template <typename Weight>
+void BasicGraph<Weight>::SearchScratch::prepare(size_t n) {
+    if (dist.size() != n) {
+        dist.assign(n, UNREACHABLE);
+        isTarget.assign(n, 0);
+    } else {
+        for (uint32_t v : touched) {
+            dist[v] = UNREACHABLE;
+        }
+    }
+    touched.clear();
+}
+
+template <typename Weight>
+typename BasicGraph<Weight>::SearchScratch&
+BasicGraph<Weight>::threadScratch() {
+    static thread_local SearchScratch scratch;
+    return scratch;
+}
 
-    distance = dist[end];
+template <typename Weight>
+typename BasicGraph<Weight>::QueueKind
+BasicGraph<Weight>::distanceSweep(const CompiledGraph& g, uint32_t source,
+                                  SearchScratch& scratch, size_t targetCount) const {
+    scratch.prepare(g.labels.size());
+    vector<Weight>& dist = scratch.dist;
+    dist[source] = 0;
+    scratch.touched.push_back(source);
+
+    return withDijkstraQueue(g, scratch, [&](auto& queue) {
+        queue.push(source, 0);
+        runDijkstra(g, queue, dist,
+            [&](uint32_t u) {
+                return targetCount > 0 && scratch.isTarget[u] && --targetCount == 0;
+            },
+            [&](uint32_t v, uint32_t) {
+                if (dist[v] == UNREACHABLE) scratch.touched.push_back(v);
+            });
+    });
+}
+
+template <typename Weight>
+bool BasicGraph<Weight>::distancesFrom(const string& source,
+                                       vector<pair<string, Weight>>& distances) const {
+    const CompiledGraph& g = compiledView();
+    auto it = g.ids.find(source);
+    if (it == g.ids.end()) {
+        cerr << "Source vertex '" << source << "' not found.\n";
+        return false;
+    }
+    SearchScratch& scratch = threadScratch();
+    distanceSweep(g, it->second, scratch, 0);
+
+    // Ids follow label order, so sorting the reached ids sorts by label
+    vector<uint32_t> reached(scratch.touched);
+    sort(reached.begin(), reached.end());
+    distances.clear();
+    distances.reserve(reached.size());
+    for (uint32_t v : reached) {
+        distances.push_back({g.labels[v], scratch.dist[v]});
+    }
+    return true;
+}
+
+template <typename Weight>
+bool BasicGraph<Weight>::distanceTable(const vector<string>& sources, const vector<string>& targets,
+                                       vector<vector<Weight>>& table) const {
+    const CompiledGraph& g = compiledView();
+    // Resolve every label once up front
+    vector<uint32_t> sourceIds, targetIds;
+    for (const string& label : sources) {
+        auto it = g.ids.find(label);
+        if (it == g.ids.end()) {
+            cerr << "Source vertex '" << label << "' not found.\n";
+            return false;
+        }
+        sourceIds.push_back(it->second);
+    }
+    for (const string& label : targets) {
+        auto it = g.ids.find(label);
+        if (it == g.ids.end()) {
+            cerr << "Target vertex '" << label << "' not found.\n";
+            return false;
+        }
+        targetIds.push_back(it->second);
+    }
+
+    // Distinct target ids: each search stops once all of them are settled
+    vector<uint32_t> distinctTargets(targetIds);
+    sort(distinctTargets.begin(), distinctTargets.end());
+    distinctTargets.erase(unique(distinctTargets.begin(), distinctTargets.end()),
+                          distinctTargets.end());
+
+    table.assign(sources.size(), vector<Weight>(targets.size(), UNREACHABLE));
+    ThreadPool::shared().parallelFor(sourceIds.size(), [&](size_t i) {
+        SearchScratch& scratch = threadScratch();
+        scratch.prepare(g.labels.size());
+        for (uint32_t t : distinctTargets) {
+            scratch.isTarget[t] = 1;
+        }
+        distanceSweep(g, sourceIds[i], scratch, distinctTargets.size());
+        for (size_t j = 0; j < targetIds.size(); ++j) {
+            table[i][j] = scratch.dist[targetIds[j]];
+        }
+        for (uint32_t t : distinctTargets) {
+            scratch.isTarget[t] = 0;
+        }
+    });
     return true;
 }
+
+// Compile the member definitions above once for each supported weight type
+template class BasicGraph<int32_t>;
+template class BasicGraph<int64_t>;
+template class BasicGraph<float>;
+template class BasicGraph<double>;
@@ -1,11 +1,14 @@
 #include "../include/QuadTree.h"
+#include <algorithm>
 #include <functional>
 using namespace std;
-// QuadTree Implementation for nearest neighbor search
+// QuadTree Implementation for nearest neighbor search (bucketed point-region quadtree)
 
-QuadTree::QuadTree(double minx, double miny, double maxx, double maxy) {
+QuadTree::QuadTree(double minx, double miny, double maxx, double maxy,
+                   size_t leafCapacity, int maxDepth)
+    : leafCapacity(max<size_t>(1, leafCapacity)), maxDepth(maxDepth) {
     // Create root node covering the entire region
-    root = new QuadNode(minx, miny, maxx, maxy);
+    root = new QuadNode(minx, miny, maxx, maxy, 0);
     count = 0;
 }
 
@@ -24,6 +27,32 @@ void QuadTree::destroyNode(QuadNode* node) {
     delete node;
 }
 
+QuadTree::QuadNode* QuadTree::childFor(const QuadNode* node, double x, double y) {
+    double midX = (node->minX + node->maxX) / 2.0;
+    double midY = (node->minY + node->maxY) / 2.0;
+    if (x <= midX) {
+        return (y <= midY) ? node->SW : node->NW;
+    }
+    return (y <= midY) ? node->SE : node->NE;
+}
+
+QuadTree::QuadNode* QuadTree::findLeaf(double x, double y, vector<QuadNode*>* path) const {
+    QuadNode* node = root;
+    while (!node->isLeaf()) {
+        if (path) path->push_back(node);
+        node = childFor(node, x, y);
+    }
+    return node;
+}
+
+size_t QuadTree::slotOf(const QuadNode* leaf, double x, double y) {
+    size_t slot = 0;
+    while (slot < leaf->ids.size() && !(leaf->xs[slot] == x && leaf->ys[slot] == y)) {
+        slot++;
+    }
+    return slot;
+}
+
 // Insert a new point (store) into the QuadTree
 bool QuadTree::insert(double x, double y, const string& name) {
     // Ensure the point lies within the root boundary
@@ -32,160 +61,174 @@ bool QuadTree::insert(double x, double y, const string& name) {
         return false;
     }
     // Check if a store with the same name already exists
-    QuadNode* existing = findByName(root, name);
-    if (existing != nullptr) {
+    auto existing = nameIndex.find(name);
+    if (existing != nameIndex.end()) {
+        const Store& store = stores[existing->second];
         cerr << "QuadTree: A store named '" << name << "' already exists at ("
-             << existing->x << "," << existing->y << ").\n";
+             << store.x << "," << store.y << ").\n";
+        return false;
+    }
+    QuadNode* leaf = findLeaf(x, y);
+    if (slotOf(leaf, x, y) != leaf->ids.size()) {
+        // Exactly same coordinates as existing store
+        cerr << "QuadTree: A store already exists at coordinates (" << x << "," << y << ").\n";
         return false;
     }
-    // Insert recursively into the quadtree
-    bool inserted = insertNode(root, x, y, name);
-    // if (inserted) {
-    //     cout << "Inserted store '" << name << "' at (" << x << "," << y << ").\n";
-    // }
-    return inserted;
+    uint32_t id;
+    if (!freeIds.empty()) {
+        id = freeIds.back();
+        freeIds.pop_back();
+        stores[id] = {name, x, y};
+    } else {
+        id = static_cast<uint32_t>(stores.size());
+        stores.push_back({name, x, y});
+    }
+    addToLeaf(leaf, id);
+    nameIndex.emplace(name, id);
+    count++;
+    return true;
 }
 
-// Recursive helper for insertion
-bool QuadTree::insertNode(QuadNode* node, double x, double y, const string& name) {
-    // If this node is a leaf (no children)
-    if (node->isLeaf()) {
-        if (node->name == "") {
-            // Empty leaf: place the store here
-            node->x = x;
-            node->y = y;
-            node->name = name;
-            count++;
-            return true;
-        } else {
-            // Leaf already contains a store. We need to subdivide this leaf into four children.
-            if (node->x == x && node->y == y) {
-                // Exactly same coordinates as existing store
-                cerr << "QuadTree: A store already exists at coordinates (" << x << "," << y << ").\n";
-                return false;
-            }
-            // Calculate midpoints to split current node region into four quadrants
-            double midX = (node->minX + node->maxX) / 2.0;
-            double midY = (node->minY + node->maxY) / 2.0;
-            // Create four child quadrants (NW, NE, SW, SE)
-            node->NW = new QuadNode(node->minX, midY, midX, node->maxY);
-            node->NE = new QuadNode(midX, midY, node->maxX, node->maxY);
-            node->SW = new QuadNode(node->minX, node->minY, midX, midY);
-            node->SE = new QuadNode(midX, node->minY, node->maxX, midY);
-            // Temporarily store the existing point's data
-            double oldX = node->x;
-            double oldY = node->y;
-            string oldName = node->name;
-            node->name.clear(); // clear current node's name as it's now an internal node
-            // Insert the old store into an appropriate child quadrant
-            if (oldX <= midX) {
-                if (oldY <= midY) {
-                    insertNode(node->SW, oldX, oldY, oldName);
-                } else {
-                    insertNode(node->NW, oldX, oldY, oldName);
-                }
-            } else {
-                if (oldY <= midY) {
-                    insertNode(node->SE, oldX, oldY, oldName);
-                } else {
-                    insertNode(node->NE, oldX, oldY, oldName);
-                }
-            }
-            // Now insert the new store into the appropriate child quadrant
-            if (x <= midX) {
-                if (y <= midY) {
-                    return insertNode(node->SW, x, y, name);
-                } else {
-                    return insertNode(node->NW, x, y, name);
-                }
-            } else {
-                if (y <= midY) {
-                    return insertNode(node->SE, x, y, name);
-                } else {
-                    return insertNode(node->NE, x, y, name);
-                }
-            }
-        }
-    } else {
-        // This node has children, delegate insertion to correct quadrant
-        double midX = (node->minX + node->maxX) / 2.0;
-        double midY = (node->minY + node->maxY) / 2.0;
-        if (x <= midX) {
-            if (y <= midY) {
-                return insertNode(node->SW, x, y, name);
-            } else {
-                return insertNode(node->NW, x, y, name);
-            }
-        } else {
-            if (y <= midY) {
-                return insertNode(node->SE, x, y, name);
-            } else {
-                return insertNode(node->NE, x, y, name);
-            }
-        }
+void QuadTree::addToLeaf(QuadNode* leaf, uint32_t id) {
+    double x = stores[id].x;
+    double y = stores[id].y;
+    // A full leaf splits; if its whole bucket lands in the new point's quadrant that
+    // quadrant splits again, down to maxDepth, where buckets may grow past capacity
+    while (leaf->ids.size() >= leafCapacity && leaf->depth < maxDepth) {
+        splitLeaf(leaf);
+        leaf = childFor(leaf, x, y);
+    }
+    leaf->xs.push_back(x);
+    leaf->ys.push_back(y);
+    leaf->ids.push_back(id);
+}
+
+void QuadTree::splitLeaf(QuadNode* node) {
+    // Calculate midpoints to split current node region into four quadrants
+    double midX = (node->minX + node->maxX) / 2.0;
+    double midY = (node->minY + node->maxY) / 2.0;
+    int depth = node->depth + 1;
+    // Create four child quadrants (NW, NE, SW, SE)
+    node->NW = new QuadNode(node->minX, midY, midX, node->maxY, depth);
+    node->NE = new QuadNode(midX, midY, node->maxX, node->maxY, depth);
+    node->SW = new QuadNode(node->minX, node->minY, midX, midY, depth);
+    node->SE = new QuadNode(midX, node->minY, node->maxX, midY, depth);
+    // Hand the bucket down; the node is internal from now on
+    for (size_t i = 0; i < node->ids.size(); ++i) {
+        QuadNode* child = childFor(node, node->xs[i], node->ys[i]);
+        child->xs.push_back(node->xs[i]);
+        child->ys.push_back(node->ys[i]);
+        child->ids.push_back(node->ids[i]);
     }
+    vector<double>().swap(node->xs);
+    vector<double>().swap(node->ys);
+    vector<uint32_t>().swap(node->ids);
+}
+
+bool QuadTree::mergeChildren(QuadNode* node) {
+    QuadNode* children[4] = {node->NW, node->NE, node->SW, node->SE};
+    size_t total = 0;
+    for (QuadNode* child : children) {
+        if (!child->isLeaf()) return false;
+        total += child->ids.size();
+    }
+    if (total > leafCapacity) return false;
+    for (QuadNode* child : children) {
+        node->xs.insert(node->xs.end(), child->xs.begin(), child->xs.end());
+        node->ys.insert(node->ys.end(), child->ys.begin(), child->ys.end());
+        node->ids.insert(node->ids.end(), child->ids.begin(), child->ids.end());
+        delete child;
+    }
+    node->NW = node->NE = node->SW = node->SE = nullptr;
+    return true;
 }
 
 // Remove a store by name
 bool QuadTree::remove(const string& name) {
-    // Find the node with this store name to get its coordinates
-    QuadNode* node = findByName(root, name);
-    if (node == nullptr) {
+    auto it = nameIndex.find(name);
+    if (it == nameIndex.end()) {
         cerr << "QuadTree: Store '" << name << "' not found.\n";
         return false;
     }
-    // Use the found coordinates to remove the store
-    double x = node->x;
-    double y = node->y;
-    return remove(x, y);
+    // Use the store's coordinates to remove it
+    const Store& store = stores[it->second];
+    return remove(store.x, store.y);
+}
+
+uint32_t QuadTree::detach(double x, double y) {
+    // Traverse the tree to the leaf covering (x, y), remembering the way down
+    vector<QuadNode*> path;
+    QuadNode* leaf = findLeaf(x, y, &path);
+    size_t slot = slotOf(leaf, x, y);
+    if (slot == leaf->ids.size()) return NO_STORE;
+    // Fill the slot with the bucket's last store
+    uint32_t id = leaf->ids[slot];
+    leaf->xs[slot] = leaf->xs.back();
+    leaf->ys[slot] = leaf->ys.back();
+    leaf->ids[slot] = leaf->ids.back();
+    leaf->xs.pop_back();
+    leaf->ys.pop_back();
+    leaf->ids.pop_back();
+    // Collapse quadrants that became sparse, from the bottom up
+    while (!path.empty() && mergeChildren(path.back())) {
+        path.pop_back();
+    }
+    return id;
 }
 
 // Remove a store by coordinates
 bool QuadTree::remove(double x, double y) {
-    // Traverse the tree to find the target leaf that matches (x, y)
-    QuadNode* current = root;
-    QuadNode* target = nullptr;
-    QuadNode* parent = nullptr;
-    QuadNode** parentLink = nullptr;  // pointer to the parent's child pointer for current
-    while (current != nullptr) {
-        if (current->isLeaf()) {
-            if (!current->name.empty() && current->x == x && current->y == y) {
-                target = current;
-            }
-            break;
-        }
-        // Determine which quadrant to search next
-        double midX = (current->minX + current->maxX) / 2.0;
-        double midY = (current->minY + current->maxY) / 2.0;
-        parent = current;
-        if (x <= midX) {
-            if (y <= midY) {
-                parentLink = &(current->SW);
-                current = current->SW;
-            } else {
-                parentLink = &(current->NW);
-                current = current->NW;
-            }
-        } else {
-            if (y <= midY) {
-                parentLink = &(current->SE);
-                current = current->SE;
-            } else {
-                parentLink = &(current->NE);
-                current = current->NE;
-            }
-        }
-    }
-    if (target == nullptr) {
+    uint32_t id = detach(x, y);
+    if (id == NO_STORE) {
         cerr << "QuadTree: No store found at (" << x << "," << y << ").\n";
         return false;
     }
-    // "Remove" the target by clearing its stored data (keep node structure for simplicity)
-    string removedName = target->name;
-    target->name.clear();
+    string removedName = std::move(stores[id].name);
+    stores[id].name.clear();
+    nameIndex.erase(removedName);
+    freeIds.push_back(id);
     count--;
     cout << "Removed store '" << removedName << "' from (" << x << "," << y << ").\n";
-    // Note: We do not merge empty child nodes back to a leaf to simplify implementation
+    return true;
+}
+
+// Move a store to new coordinates
+bool QuadTree::move(const string& name, double x, double y) {
+    auto it = nameIndex.find(name);
+    if (it == nameIndex.end()) {
+        cerr << "QuadTree: Store '" << name << "' not found.\n";
+        return false;
+    }
+    if (x < root->minX || x > root->maxX || y < root->minY || y > root->maxY) {
+        cerr << "QuadTree: Point (" << x << "," << y << ") is out of the boundary.\n";
+        return false;
+    }
+    uint32_t id = it->second;
+    Store& store = stores[id];
+    if (store.x == x && store.y == y) return true;
+    QuadNode* target = findLeaf(x, y);
+    if (slotOf(target, x, y) != target->ids.size()) {
+        cerr << "QuadTree: A store already exists at coordinates (" << x << "," << y << ").\n";
+        return false;
+    }
+    // The store keeps its id (and index entry); only its place in the tree changes.
+    // Detaching may merge quadrants, so the target leaf is looked up again.
+    detach(store.x, store.y);
+    store.x = x;
+    store.y = y;
+    addToLeaf(findLeaf(x, y), id);
+    return true;
+}
+
+// Look up a store's coordinates by name
+bool QuadTree::findStore(const string& name, double& outX, double& outY) const {
+    auto it = nameIndex.find(name);
+    if (it == nameIndex.end()) {
+        cerr << "QuadTree: Store '" << name << "' not found.\n";
+        return false;
+    }
+    outX = stores[it->second].x;
+    outY = stores[it->second].y;
     return true;
 }
 
@@ -196,13 +239,13 @@ bool QuadTree::findNearest(double x, double y, string& nearestName, double& near
         return false;
     }
     double bestDist = numeric_limits<double>::max();
-    QuadNode* bestNode = nullptr;
+    uint32_t bestId = NO_STORE;
     // Start recursive search for nearest
-    nearestNode(root, x, y, bestDist, bestNode);
-    if (bestNode) {
-        nearestName = bestNode->name;
-        nearestX = bestNode->x;
-        nearestY = bestNode->y;
+    nearestNode(root, x, y, bestDist, bestId);
+    if (bestId != NO_STORE) {
+        nearestName = stores[bestId].name;
+        nearestX = stores[bestId].x;
+        nearestY = stores[bestId].y;
         // Calculate actual Euclidean distance from target (x, y)
         distance = sqrt((nearestX - x) * (nearestX - x) + (nearestY - y) * (nearestY - y));
         return true;
@@ -210,19 +253,108 @@ bool QuadTree::findNearest(double x, double y, string& nearestName, double& near
     return false;
 }
 
+double QuadTree::distSqToRegion(const QuadNode* node, double x, double y) {
+    double dx = 0.0, dy = 0.0;
+    if (x < node->minX) {
+        dx = node->minX - x;
+    } else if (x > node->maxX) {
+        dx = x - node->maxX;
+    }
+    if (y < node->minY) {
+        dy = node->minY - y;
+    } else if (y > node->maxY) {
+        dy = y - node->maxY;
+    }
+    return dx * dx + dy * dy;
+}
+
+template <typename Visit>
+void QuadTree::visitByDistance(double x, double y, double maxDistSq, Visit visit) const {
+    // One min-heap holds both quadrants (keyed by the distance to their region) and
+    // stores (keyed by their own distance). A quadrant's key never exceeds that of
+    // anything inside it, so stores come off the heap in distance order.
+    struct Entry {
+        double distSq;
+        const QuadNode* node;  // nullptr for a store entry
+        uint32_t id;
+        bool operator>(const Entry& other) const { return distSq > other.distSq; }
+    };
+    static thread_local vector<Entry> heap;
+    heap.clear();
+    auto push = [&](const Entry& entry) {
+        heap.push_back(entry);
+        push_heap(heap.begin(), heap.end(), greater<Entry>());
+    };
+    push({distSqToRegion(root, x, y), root, NO_STORE});
+    while (!heap.empty()) {
+        pop_heap(heap.begin(), heap.end(), greater<Entry>());
+        Entry top = heap.back();
+        heap.pop_back();
+        // Everything still on the heap is at least this far away
+        if (top.distSq > maxDistSq) return;
+        if (top.node == nullptr) {
+            if (!visit(top.id, top.distSq)) return;
+            continue;
+        }
+        const QuadNode* node = top.node;
+        if (node->isLeaf()) {
+            for (size_t i = 0; i < node->ids.size(); ++i) {
+                double dx = node->xs[i] - x;
+                double dy = node->ys[i] - y;
+                push({dx * dx + dy * dy, nullptr, node->ids[i]});
+            }
+        } else {
+            for (const QuadNode* child : {node->NW, node->NE, node->SW, node->SE}) {
+                push({distSqToRegion(child, x, y), child, NO_STORE});
+            }
+        }
+    }
+}
+
+// Find the k nearest stores to (x, y)
+bool QuadTree::findKNearest(double x, double y, size_t k, vector<NearbyStore>& out) const {
+    out.clear();
+    if (count == 0) {
+        cerr << "QuadTree: No stores in the quadtree.\n";
+        return false;
+    }
+    if (k == 0) return false;
+    visitByDistance(x, y, numeric_limits<double>::infinity(), [&](uint32_t id, double distSq) {
+        const Store& store = stores[id];
+        out.push_back({&store.name, store.x, store.y, sqrt(distSq)});
+        return out.size() < k;
+    });
+    return true;
+}
+
+// Find all stores within radius of (x, y)
+bool QuadTree::findWithinRadius(double x, double y, double radius,
+                                vector<NearbyStore>& out) const {
+    out.clear();
+    if (count == 0 || radius < 0) return false;
+    visitByDistance(x, y, radius * radius, [&](uint32_t id, double distSq) {
+        const Store& store = stores[id];
+        out.push_back({&store.name, store.x, store.y, sqrt(distSq)});
+        return true;
+    });
+    return !out.empty();
+}
+
 // Recursive helper to find nearest neighbor in subtree
-void QuadTree::nearestNode(QuadNode* node, double targetX, double targetY, double& bestDist, QuadNode*& bestNode) const {
+void QuadTree::nearestNode(const QuadNode* node, double targetX, double targetY, double& bestDist, uint32_t& bestId) const {
     if (node == nullptr) return;
-    // If this is a leaf with a store, check the distance to it
+    // If this is a leaf, scan its bucket
     if (node->isLeaf()) {
-        if (!node->name.empty()) {
+        const double* xs = node->xs.data();
+        const double* ys = node->ys.data();
+        for (size_t i = 0; i < node->ids.size(); ++i) {
             // Calculate squared distance (to avoid sqrt for comparison)
-            double dx = node->x - targetX;
-            double dy = node->y - targetY;
+            double dx = xs[i] - targetX;
+            double dy = ys[i] - targetY;
             double distSq = dx * dx + dy * dy;
             if (distSq < bestDist) {
                 bestDist = distSq;
-                bestNode = node;
+                bestId = node->ids[i];
             }
         }
         return;
@@ -230,10 +362,10 @@ void QuadTree::nearestNode(QuadNode* node, double targetX, double targetY, doubl
     // Determine which quadrant the target falls into (primary search quadrant)
     double midX = (node->minX + node->maxX) / 2.0;
     double midY = (node->minY + node->maxY) / 2.0;
-    QuadNode* primary = nullptr;
-    QuadNode* other1 = nullptr;
-    QuadNode* other2 = nullptr;
-    QuadNode* other3 = nullptr;
+    const QuadNode* primary = nullptr;
+    const QuadNode* other1 = nullptr;
+    const QuadNode* other2 = nullptr;
+    const QuadNode* other3 = nullptr;
     if (targetX <= midX) {
         if (targetY <= midY) {
             primary = node->SW;
@@ -253,50 +385,23 @@ void QuadTree::nearestNode(QuadNode* node, double targetX, double targetY, doubl
     }
     // Search in the primary quadrant first (where the point lies)
     if (primary) {
-        nearestNode(primary, targetX, targetY, bestDist, bestNode);
+        nearestNode(primary, targetX, targetY, bestDist, bestId);
     }
     // A helper lambda to compute squared distance from target to a quadrant region
-    auto distToRegion = [&](QuadNode* qnode) {
+    auto distToRegion = [&](const QuadNode* qnode) {
         if (!qnode) return numeric_limits<double>::infinity();
-        double dx = 0.0, dy = 0.0;
-        if (targetX < qnode->minX) {
-            dx = qnode->minX - targetX;
-        } else if (targetX > qnode->maxX) {
-            dx = targetX - qnode->maxX;
-        }
-        if (targetY < qnode->minY) {
-            dy = qnode->minY - targetY;
-        } else if (targetY > qnode->maxY) {
-            dy = targetY - qnode->maxY;
-        }
-        return dx * dx + dy * dy;
+        return distSqToRegion(qnode, targetX, targetY);
     };
     // Check other quadrants if their region could contain a closer point
     if (other1 && distToRegion(other1) < bestDist) {
-        nearestNode(other1, targetX, targetY, bestDist, bestNode);
+        nearestNode(other1, targetX, targetY, bestDist, bestId);
     }
     if (other2 && distToRegion(other2) < bestDist) {
-        nearestNode(other2, targetX, targetY, bestDist, bestNode);
+        nearestNode(other2, targetX, targetY, bestDist, bestId);
     }
     if (other3 && distToRegion(other3) < bestDist) {
-        nearestNode(other3, targetX, targetY, bestDist, bestNode);
-    }
-}
-
-// Find a node by store name (DFS traversal)
-QuadTree::QuadNode* QuadTree::findByName(QuadNode* node, const string& name) const {
-    if (node == nullptr) return nullptr;
-    if (node->name == name) {
-        return node;
+        nearestNode(other3, targetX, targetY, bestDist, bestId);
     }
-    // Recursively search all children
-    QuadNode* found = findByName(node->NW, name);
-    if (found) return found;
-    found = findByName(node->NE, name);
-    if (found) return found;
-    found = findByName(node->SW, name);
-    if (found) return found;
-    return findByName(node->SE, name);
 }
 
 // Print all store locations in the QuadTree
@@ -305,8 +410,8 @@ void QuadTree::printLocations() const {
     // Lambda for recursive traversal
     function<void(QuadNode*)> traverse = [&](QuadNode* node) {
         if (node == nullptr) return;
-        if (!node->name.empty()) {
-            cout << "  " << node->name << " (" << node->x << ", " << node->y << ")\n";
+        for (uint32_t id : node->ids) {
+            cout << "  " << stores[id].name << " (" << stores[id].x << ", " << stores[id].y << ")\n";
         }
         if (!node->isLeaf()) {
             traverse(node->NW);
@@ -0,0 +1,149 @@
+#include "../include/ThreadPool.h"
+#include <algorithm>
+#include <cstdint>
+using namespace std;
+// Work-stealing thread pool used for the batched and parallel queries
+
+// Worker index of the current thread within its pool (SIZE_MAX outside any pool)
+static thread_local const ThreadPool* currentPool = nullptr;
+static thread_local size_t currentWorker = SIZE_MAX;
+
+ThreadPool::ThreadPool(size_t threads) : queued(0), stopping(false), nextQueue(0) {
+    if (threads == 0) {
+        threads = max(1u, thread::hardware_concurrency());
+    }
+    for (size_t i = 0; i < threads; ++i) {
+        queues.push_back(make_unique<WorkerQueue>());
+    }
+    for (size_t i = 0; i < threads; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        lock_guard<mutex> guard(idleLock);
+        stopping = true;
+    }
+    idleCv.notify_all();
+    for (thread& worker : workers) {
+        worker.join();
+    }
+}
+
+size_t ThreadPool::size() const {
+    return workers.size();
+}
+
+void ThreadPool::submit(function<void()> task) {
+    size_t target = (currentPool == this) ? currentWorker
+                                          : nextQueue.fetch_add(1) % queues.size();
+    // Count the task before it becomes visible so 'queued' never underflows
+    {
+        lock_guard<mutex> guard(idleLock);
+        queued++;
+    }
+    {
+        lock_guard<mutex> guard(queues[target]->lock);
+        queues[target]->tasks.push_back(std::move(task));
+    }
+    idleCv.notify_one();
+}
+
+bool ThreadPool::tryPop(size_t self, function<void()>& task) {
+    size_t n = queues.size();
+    bool found = false;
+    // Own deque first (newest task, still warm in cache)
+    if (self < n) {
+        WorkerQueue& own = *queues[self];
+        lock_guard<mutex> guard(own.lock);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            found = true;
+        }
+    }
+    // Otherwise steal the oldest task from another deque
+    for (size_t i = 1; !found && i <= n; ++i) {
+        size_t victim = (self < n) ? (self + i) % n : i - 1;
+        if (victim == self) continue;
+        WorkerQueue& other = *queues[victim];
+        lock_guard<mutex> guard(other.lock);
+        if (!other.tasks.empty()) {
+            task = std::move(other.tasks.front());
+            other.tasks.pop_front();
+            found = true;
+        }
+    }
+    if (found) {
+        lock_guard<mutex> guard(idleLock);
+        queued--;
+    }
+    return found;
+}
+
+void ThreadPool::workerLoop(size_t self) {
+    currentPool = this;
+    currentWorker = self;
+    function<void()> task;
+    while (true) {
+        if (tryPop(self, task)) {
+            task();
+            task = nullptr;
+            continue;
+        }
+        unique_lock<mutex> lock(idleLock);
+        idleCv.wait(lock, [this]() { return stopping || queued > 0; });
+        if (stopping && queued == 0) {
+            return;
+        }
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, const function<void(size_t)>& body) {
+    if (count == 0) return;
+    // A few chunks per worker so stealing can even out uneven chunk costs
+    size_t chunks = min(count, workers.size() * 4);
+    size_t chunkSize = (count + chunks - 1) / chunks;
+    chunks = (count + chunkSize - 1) / chunkSize;
+
+    struct Batch {
+        atomic<size_t> left;
+        mutex lock;
+        condition_variable done;
+    };
+    auto batch = make_shared<Batch>();
+    batch->left = chunks;
+    for (size_t c = 0; c < chunks; ++c) {
+        size_t first = c * chunkSize;
+        size_t last = min(count, first + chunkSize);
+        submit([batch, first, last, &body]() {
+            for (size_t i = first; i < last; ++i) {
+                body(i);
+            }
+            if (batch->left.fetch_sub(1) == 1) {
+                lock_guard<mutex> guard(batch->lock);
+                batch->done.notify_all();
+            }
+        });
+    }
+
+    // Help out instead of blocking; once nothing is queued, every remaining chunk
+    // is already running, so it is safe to sleep until the last one finishes
+    size_t self = (currentPool == this) ? currentWorker : SIZE_MAX;
+    function<void()> task;
+    while (batch->left.load() > 0) {
+        if (tryPop(self, task)) {
+            task();
+            task = nullptr;
+            continue;
+        }
+        unique_lock<mutex> lock(batch->lock);
+        batch->done.wait(lock, [&batch]() { return batch->left.load() == 0; });
+    }
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
@@ -0,0 +1,6 @@
+#include "../include/UnrolledSkipList.h"
+using namespace std;
+// UnrolledSkipList is a header-only template; the aisle -> description layout is
+// instantiated here once.
+
+template class UnrolledSkipList<int, string>;
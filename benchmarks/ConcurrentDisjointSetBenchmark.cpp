@@ -0,0 +1,74 @@
+// Benchmark: bulk union-find, serial DisjointSet vs. ConcurrentDisjointSet::unionBatch
+// on 1..N worker threads.
+//
+// Build from the repository root (one command, wrapped over several lines):
+//   g++ -std=c++20 -O2 -pthread -ICSC307_GoShopProject/include
+//       benchmarks/ConcurrentDisjointSetBenchmark.cpp CSC307_GoShopProject/src/DisjointSet.cpp
+//       CSC307_GoShopProject/src/ConcurrentDisjointSet.cpp
+//       CSC307_GoShopProject/src/ThreadPool.cpp -o concurrent_disjointset_benchmark
+//
+// Usage: concurrent_disjointset_benchmark [items] [edges]   (default: 2000000 6000000)
+//
+// Models the nightly category reconciliation: 'edges' random co-purchase pairs over
+// 'items' catalog ids. The serial baseline calls DisjointSet::unionIds per pair; the
+// concurrent runs split the same list across a ThreadPool of each size. Every run
+// must end with the same number of components.
+#include "DisjointSet.h"
+#include "ConcurrentDisjointSet.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+using namespace std;
+
+int main(int argc, char* argv[]) {
+    size_t items = argc > 1 ? strtoull(argv[1], nullptr, 10) : 2000000;
+    size_t edgeCount = argc > 2 ? strtoull(argv[2], nullptr, 10) : 6000000;
+
+    mt19937 rng(42);
+    vector<pair<uint32_t, uint32_t>> edges(edgeCount);
+    for (auto& edge : edges) {
+        edge = {static_cast<uint32_t>(rng() % items), static_cast<uint32_t>(rng() % items)};
+    }
+
+    DisjointSet serial;
+    serial.reserve(items);
+    for (size_t i = 0; i < items; ++i) {
+        serial.makeSet(to_string(i));
+    }
+    auto start = chrono::steady_clock::now();
+    for (const auto& edge : edges) {
+        serial.unionIds(edge.first, edge.second);
+    }
+    double serialSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    size_t expected = serial.numSets();
+
+    cout << items << " items, " << edgeCount << " edges, " << expected << " components\n";
+    cout << setw(12) << "threads" << setw(14) << "Medges/s" << setw(10) << "speedup" << "\n";
+    cout << fixed << setprecision(2);
+    cout << setw(12) << "serial" << setw(14) << edgeCount / serialSeconds / 1e6 << setw(10)
+         << 1.0 << "\n";
+
+    size_t maxThreads = max<size_t>(4, thread::hardware_concurrency());
+    for (size_t threads = 1; threads <= maxThreads; threads *= 2) {
+        ThreadPool pool(threads);
+        ConcurrentDisjointSet concurrent(items);
+        start = chrono::steady_clock::now();
+        size_t components = concurrent.unionBatch(edges, pool);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        if (components != expected) {
+            cerr << "component count mismatch: " << components << " vs " << expected << "\n";
+        }
+        cout << setw(12) << threads << setw(14) << edgeCount / seconds / 1e6 << setw(10)
+             << serialSeconds / seconds << "\n";
+    }
+    return 0;
+}
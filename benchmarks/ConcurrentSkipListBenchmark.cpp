@@ -0,0 +1,104 @@
+// Benchmark: ConcurrentSkipList vs. the single-threaded SkipList behind a lock.
+//
+// Build from the repository root (one command, wrapped over several lines):
+//   g++ -std=c++20 -O2 -pthread -ICSC307_GoShopProject/include
+//       benchmarks/ConcurrentSkipListBenchmark.cpp CSC307_GoShopProject/src/SkipList.cpp
+//       CSC307_GoShopProject/src/ConcurrentSkipList.cpp -o concurrent_skiplist_benchmark
+//
+// Kiosk lookups (search) race with inventory-feed edits (an even mix of insert and
+// remove, so the list stays about half full) over KEYS aisle numbers. SkipList is not
+// thread-safe, so it is measured behind a mutex and behind a reader-writer lock; it
+// prints a message for every duplicate insert or missing remove, so cerr is muted
+// while the workloads run. Throughput is total operations per second over all threads.
+#include "SkipList.h"
+#include "ConcurrentSkipList.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+
+static const int KEYS = 4096;
+static const int OPS_PER_THREAD = 200000;
+
+// Run 'threads' workers doing OPS_PER_THREAD operations each; returns Mops/s
+template <typename Search, typename Insert, typename Remove>
+static double run(int threads, int readPercent, Search search, Insert insert, Remove remove) {
+    vector<thread> workers;
+    auto start = chrono::steady_clock::now();
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([=]() {
+            mt19937 rng(1000 + t);
+            string value;
+            for (int i = 0; i < OPS_PER_THREAD; ++i) {
+                int key = static_cast<int>(rng() % KEYS);
+                int roll = static_cast<int>(rng() % 100);
+                if (roll < readPercent) {
+                    search(key, value);
+                } else if (roll % 2 == 0) {
+                    insert(key, "Aisle " + to_string(key));
+                } else {
+                    remove(key);
+                }
+            }
+        });
+    }
+    for (thread& worker : workers) {
+        worker.join();
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return threads * static_cast<double>(OPS_PER_THREAD) / seconds / 1e6;
+}
+
+int main() {
+    int maxThreads = max(4, static_cast<int>(thread::hardware_concurrency()));
+    vector<int> threadCounts;
+    for (int t = 1; t <= maxThreads; t *= 2) {
+        threadCounts.push_back(t);
+    }
+
+    cout << setw(8) << "reads" << setw(9) << "threads" << setw(16) << "mutex (Mops/s)"
+         << setw(17) << "rwlock (Mops/s)" << setw(19) << "lock-free (Mops/s)" << "\n";
+    for (int readPercent : {100, 90, 50}) {
+        for (int threads : threadCounts) {
+            SkipList<> plain;
+            SkipList<> shared;
+            ConcurrentSkipList lockFree;
+            for (int key = 0; key < KEYS; key += 2) {
+                plain.insert(key, "Aisle " + to_string(key));
+                shared.insert(key, "Aisle " + to_string(key));
+                lockFree.insert(key, "Aisle " + to_string(key));
+            }
+
+            cerr.setstate(ios::failbit);
+            mutex plainLock;
+            double mutexRate = run(threads, readPercent,
+                [&](int key, string& out) { lock_guard<mutex> g(plainLock); plain.search(key, out); },
+                [&](int key, const string& v) { lock_guard<mutex> g(plainLock); plain.insert(key, v); },
+                [&](int key) { lock_guard<mutex> g(plainLock); plain.remove(key); });
+
+            shared_mutex rwLock;
+            double rwRate = run(threads, readPercent,
+                [&](int key, string& out) { shared_lock<shared_mutex> g(rwLock); shared.search(key, out); },
+                [&](int key, const string& v) { unique_lock<shared_mutex> g(rwLock); shared.insert(key, v); },
+                [&](int key) { unique_lock<shared_mutex> g(rwLock); shared.remove(key); });
+
+            double lockFreeRate = run(threads, readPercent,
+                [&](int key, string& out) { lockFree.search(key, out); },
+                [&](int key, const string& v) { lockFree.insert(key, v); },
+                [&](int key) { lockFree.remove(key); });
+            cerr.clear();
+
+            cout << setw(7) << readPercent << "%" << setw(9) << threads << fixed << setprecision(2)
+                 << setw(16) << mutexRate << setw(17) << rwRate << setw(19) << lockFreeRate << "\n";
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,77 @@
+// Benchmark: incremental repair of a watched shortest-path tree vs. full recompute.
+//
+// Build from the repository root (one command, wrapped over several lines):
+//   g++ -std=c++20 -O2 -pthread -ICSC307_GoShopProject/include
+//       benchmarks/DynamicTreeBenchmark.cpp CSC307_GoShopProject/src/Graph.cpp
+//       CSC307_GoShopProject/src/ThreadPool.cpp -o dynamic_tree_benchmark
+//
+// Each store map is an n x n grid of aisle intersections with random distances,
+// watched from the corner "0,0". An aisle closure is simulated by raising one edge
+// to a huge weight with updateEdge and then reopening it; the average cost of such
+// an edit (tree repair included) is compared with rebuilding the tree from scratch.
+#include "Graph.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+using namespace std;
+
+static string node(int row, int col) {
+    return to_string(row) + "," + to_string(col);
+}
+
+int main() {
+    const int CLOSED = 1000000;
+    const int EDITS = 2000;
+    const int REBUILDS = 20;
+    mt19937 rng(307);
+
+    cout << setw(10) << "vertices" << setw(18) << "edit+repair (us)"
+         << setw(20) << "full recompute (us)" << setw(10) << "speedup" << "\n";
+    for (int n : {50, 100, 200, 400}) {
+        Graph graph;
+        for (int r = 0; r < n; ++r) {
+            for (int c = 0; c < n; ++c) {
+                graph.addVertex(node(r, c));
+            }
+        }
+        // Horizontal and vertical aisles, remembered so closures can pick one
+        vector<pair<string, string>> edges;
+        vector<int> weights;
+        for (int r = 0; r < n; ++r) {
+            for (int c = 0; c < n; ++c) {
+                if (c + 1 < n) edges.push_back({node(r, c), node(r, c + 1)});
+                if (r + 1 < n) edges.push_back({node(r, c), node(r + 1, c)});
+            }
+        }
+        for (const auto& edge : edges) {
+            weights.push_back(1 + static_cast<int>(rng() % 20));
+            graph.addEdge(edge.first, edge.second, weights.back());
+        }
+        graph.compile();
+
+        // Full recompute: rebuilding the watched tree runs a complete Dijkstra
+        auto start = chrono::steady_clock::now();
+        for (int i = 0; i < REBUILDS; ++i) {
+            graph.watchSource("0,0");
+        }
+        double fullUs = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count()
+                        / REBUILDS;
+
+        // Incremental: close an aisle, then reopen it (two edits per iteration)
+        start = chrono::steady_clock::now();
+        for (int i = 0; i < EDITS / 2; ++i) {
+            size_t e = rng() % edges.size();
+            graph.updateEdge(edges[e].first, edges[e].second, CLOSED);
+            graph.updateEdge(edges[e].first, edges[e].second, weights[e]);
+        }
+        double editUs = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count()
+                        / EDITS;
+
+        cout << setw(10) << n * n << setw(18) << fixed << setprecision(2) << editUs
+             << setw(20) << fullUs << setw(9) << setprecision(1) << fullUs / editUs << "x\n";
+    }
+    return 0;
+}
@@ -0,0 +1,93 @@
+// Benchmark: building a QuadTree of 1M stores with name-indexed insert, lookup, move
+// and remove.
+//
+// Build from the repository root (one command, wrapped over several lines):
+//   g++ -std=c++20 -O2 -ICSC307_GoShopProject/include
+//       benchmarks/QuadTreeInsertBenchmark.cpp CSC307_GoShopProject/src/QuadTree.cpp
+//       -o quadtree_insert_benchmark
+//
+// Usage: quadtree_insert_benchmark [stores]   (default: 1000000)
+//
+// Stores are spread uniformly over a 10000 x 10000 map, with every tenth one placed
+// in a dense "mall" cluster. Every insert checks for a duplicate name and remove
+// by name finds the store, both through the name index; before the index each
+// was a depth-first search of the whole tree, so inserting N stores cost O(N^2).
+// QuadTree::remove reports every removal on cout, so cout is muted while it runs.
+#include "QuadTree.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+using namespace std;
+
+// Time body() and return nanoseconds per operation
+template <typename Body>
+static double perOp(size_t ops, Body body) {
+    auto start = chrono::steady_clock::now();
+    body();
+    return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / ops;
+}
+
+int main(int argc, char* argv[]) {
+    size_t n = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+
+    mt19937 rng(42);
+    uniform_real_distribution<double> anywhere(0.0, 10000.0);
+    uniform_real_distribution<double> mall(5000.0, 5000.5);
+    vector<string> names(n);
+    vector<double> xs(n), ys(n);
+    for (size_t i = 0; i < n; ++i) {
+        names[i] = "Store #" + to_string(i);
+        bool clustered = (i % 10 == 0);
+        xs[i] = clustered ? mall(rng) : anywhere(rng);
+        ys[i] = clustered ? mall(rng) : anywhere(rng);
+    }
+    vector<size_t> order(n);
+    for (size_t i = 0; i < n; ++i) order[i] = i;
+    shuffle(order.begin(), order.end(), rng);
+
+    QuadTree tree(0.0, 0.0, 10000.0, 10000.0);
+    size_t inserted = 0;
+    double insertNs = perOp(n, [&]() {
+        for (size_t i = 0; i < n; ++i) {
+            inserted += tree.insert(xs[i], ys[i], names[i]);
+        }
+    });
+    double x, y;
+    size_t found = 0;
+    double lookupNs = perOp(n, [&]() {
+        for (size_t i : order) {
+            found += tree.findStore(names[i], x, y);
+        }
+    });
+    size_t moves = n / 10;
+    double moveNs = perOp(moves, [&]() {
+        for (size_t k = 0; k < moves; ++k) {
+            size_t i = order[k];
+            tree.move(names[i], anywhere(rng), anywhere(rng));
+        }
+    });
+    streambuf* console = cout.rdbuf(nullptr);
+    double removeNs = perOp(n, [&]() {
+        for (size_t i : order) {
+            tree.remove(names[i]);
+        }
+    });
+    cout.rdbuf(console);
+
+    if (inserted != n || found != n || tree.size() != 0) {
+        cerr << "unexpected results: " << inserted << " inserted, " << found << " found, "
+             << tree.size() << " left\n";
+    }
+    cout << n << " stores (ns/op)\n" << fixed << setprecision(1);
+    cout << setw(10) << "insert" << setw(10) << insertNs << "\n";
+    cout << setw(10) << "lookup" << setw(10) << lookupNs << "\n";
+    cout << setw(10) << "move" << setw(10) << moveNs << "\n";
+    cout << setw(10) << "remove" << setw(10) << removeNs << "\n";
+    return 0;
+}
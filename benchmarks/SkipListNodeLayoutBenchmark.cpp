@@ -0,0 +1,152 @@
+// Benchmark: SkipList node layout, per-node new + vector<Node*> (before) vs. arena
+// blocks with inline forward pointers (after).
+//
+// Build from the repository root (one command, wrapped over several lines):
+//   g++ -std=c++20 -O2 -ICSC307_GoShopProject/include
+//       benchmarks/SkipListNodeLayoutBenchmark.cpp CSC307_GoShopProject/src/SkipList.cpp
+//       -o skiplist_node_layout_benchmark
+//
+// LegacySkipList below is the previous SkipList node layout, kept here only as the
+// baseline: each node is its own allocation holding a vector of forward pointers
+// (a second allocation) and the value string. Both lists use the same level
+// distribution, so the difference is memory layout and allocation alone. Keys are
+// inserted and then searched in random order; values are either short enough for the
+// string's inline buffer or long enough to need a heap buffer.
+#include "SkipList.h"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+using namespace std;
+
+class LegacySkipList {
+private:
+    struct Node {
+        int key;
+        string value;
+        vector<Node*> forward;
+        Node(int k, const string& val, int level) : key(k), value(val), forward(level + 1, nullptr) {}
+    };
+    static const int MAX_LEVEL = 6;
+
+    int level = 0;
+    Node* head = new Node(INT_MIN, "", MAX_LEVEL);
+
+    int randomLevel() const {
+        int lvl = 0;
+        while (((double) rand() / RAND_MAX) < 0.5 && lvl < MAX_LEVEL) {
+            lvl++;
+        }
+        return lvl;
+    }
+
+public:
+    ~LegacySkipList() {
+        Node* current = head;
+        while (current != nullptr) {
+            Node* next = current->forward[0];
+            delete current;
+            current = next;
+        }
+    }
+
+    bool insert(int key, const string& value) {
+        vector<Node*> update(MAX_LEVEL + 1);
+        Node* current = head;
+        for (int i = level; i >= 0; --i) {
+            while (current->forward[i] && current->forward[i]->key < key) {
+                current = current->forward[i];
+            }
+            update[i] = current;
+        }
+        current = current->forward[0];
+        if (current && current->key == key) return false;
+        int newLevel = randomLevel();
+        if (newLevel > level) {
+            for (int i = level + 1; i <= newLevel; ++i) update[i] = head;
+            level = newLevel;
+        }
+        Node* newNode = new Node(key, value, newLevel);
+        for (int i = 0; i <= newLevel; ++i) {
+            newNode->forward[i] = update[i]->forward[i];
+            update[i]->forward[i] = newNode;
+        }
+        return true;
+    }
+
+    bool search(int key, string& outValue) const {
+        Node* current = head;
+        for (int i = level; i >= 0; --i) {
+            while (current->forward[i] && current->forward[i]->key < key) {
+                current = current->forward[i];
+            }
+        }
+        current = current->forward[0];
+        if (current && current->key == key) {
+            outValue = current->value;
+            return true;
+        }
+        return false;
+    }
+};
+
+struct Latency {
+    double insertNs;
+    double searchNs;
+};
+
+// Insert every key, then search every key, each in its own random order
+template <typename List>
+static Latency measure(const vector<int>& insertOrder, const vector<int>& searchOrder,
+                       const string& padding) {
+    srand(7);
+    List list;
+    auto start = chrono::steady_clock::now();
+    for (int key : insertOrder) {
+        list.insert(key, padding + to_string(key));
+    }
+    auto middle = chrono::steady_clock::now();
+    string value;
+    size_t found = 0;
+    for (int key : searchOrder) {
+        found += list.search(key, value);
+    }
+    auto end = chrono::steady_clock::now();
+    if (found != searchOrder.size()) {
+        cerr << "search missed keys\n";
+    }
+    double n = static_cast<double>(insertOrder.size());
+    return {chrono::duration<double, nano>(middle - start).count() / n,
+            chrono::duration<double, nano>(end - middle).count() / n};
+}
+
+int main() {
+    mt19937 rng(42);
+    cout << setw(8) << "keys" << setw(8) << "value" << setw(15) << "insert before"
+         << setw(14) << "insert after" << setw(15) << "search before" << setw(14)
+         << "search after" << "   (ns/op)\n";
+    for (int n : {1000, 10000, 50000}) {
+        vector<int> insertOrder(n);
+        for (int i = 0; i < n; ++i) insertOrder[i] = i * 3;
+        vector<int> searchOrder = insertOrder;
+        shuffle(insertOrder.begin(), insertOrder.end(), rng);
+        shuffle(searchOrder.begin(), searchOrder.end(), rng);
+
+        // "A" + key fits the inline buffer; the long prefix forces a heap buffer
+        for (const string& padding : {string("A"), string("Frozen: Pizza, Ice Cream, Vegetables #")}) {
+            Latency before = measure<LegacySkipList>(insertOrder, searchOrder, padding);
+            Latency after = measure<SkipList<>>(insertOrder, searchOrder, padding);
+            cout << setw(8) << n << setw(8) << (padding.size() == 1 ? "short" : "long")
+                 << fixed << setprecision(1) << setw(15) << before.insertNs << setw(14)
+                 << after.insertNs << setw(15) << before.searchNs << setw(14) << after.searchNs
+                 << "\n";
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,94 @@
+// Benchmark: classic SkipList (one node per key) vs. UnrolledSkipList (blocks of keys
+// searched with SIMD compares).
+//
+// Build from the repository root (one command, wrapped over several lines):
+//   g++ -std=c++20 -O2 -ICSC307_GoShopProject/include
+//       benchmarks/UnrolledSkipListBenchmark.cpp CSC307_GoShopProject/src/SkipList.cpp
+//       CSC307_GoShopProject/src/UnrolledSkipList.cpp -o unrolled_skiplist_benchmark
+//
+// Usage: unrolled_skiplist_benchmark [size ...]   (default: 1000 100000 10000000)
+//
+// Both lists map int keys to int values. Keys are inserted in random order, then
+// LOOKUPS random present keys and LOOKUPS random absent keys are searched. The
+// 10M-entry classic list needs about half a gigabyte.
+#include "SkipList.h"
+#include "UnrolledSkipList.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+using namespace std;
+
+static const int LOOKUPS = 1000000;
+
+struct Latency {
+    double insertNs;
+    double hitNs;
+    double missNs;
+};
+
+// Insert every key, then search present keys (even) and absent keys (odd)
+template <typename List>
+static Latency measure(const vector<int>& insertOrder, const vector<int>& hits,
+                       const vector<int>& misses) {
+    srand(7);
+    List list;
+    auto start = chrono::steady_clock::now();
+    for (int key : insertOrder) {
+        list.insert(key, key);
+    }
+    auto inserted = chrono::steady_clock::now();
+    int value;
+    size_t found = 0;
+    for (int key : hits) {
+        found += list.search(key, value);
+    }
+    auto searched = chrono::steady_clock::now();
+    for (int key : misses) {
+        found += list.search(key, value);
+    }
+    auto end = chrono::steady_clock::now();
+    if (found != hits.size()) {
+        cerr << "search results are wrong\n";
+    }
+    return {chrono::duration<double, nano>(inserted - start).count() / insertOrder.size(),
+            chrono::duration<double, nano>(searched - inserted).count() / hits.size(),
+            chrono::duration<double, nano>(end - searched).count() / misses.size()};
+}
+
+int main(int argc, char* argv[]) {
+    vector<int> sizes;
+    for (int i = 1; i < argc; ++i) {
+        sizes.push_back(atoi(argv[i]));
+    }
+    if (sizes.empty()) {
+        sizes = {1000, 100000, 10000000};
+    }
+
+    mt19937 rng(42);
+    cout << setw(10) << "keys" << setw(10) << "list" << setw(10) << "insert" << setw(10)
+         << "hit" << setw(10) << "miss" << "   (ns/op)\n";
+    for (int n : sizes) {
+        vector<int> insertOrder(n);
+        for (int i = 0; i < n; ++i) insertOrder[i] = i * 2;
+        shuffle(insertOrder.begin(), insertOrder.end(), rng);
+        vector<int> hits(LOOKUPS), misses(LOOKUPS);
+        for (int i = 0; i < LOOKUPS; ++i) {
+            hits[i] = static_cast<int>(rng() % n) * 2;
+            misses[i] = static_cast<int>(rng() % n) * 2 + 1;
+        }
+
+        Latency classic = measure<SkipList<int, int>>(insertOrder, hits, misses);
+        Latency unrolled = measure<UnrolledSkipList<int, int>>(insertOrder, hits, misses);
+        cout << fixed << setprecision(1);
+        cout << setw(10) << n << setw(10) << "classic" << setw(10) << classic.insertNs
+             << setw(10) << classic.hitNs << setw(10) << classic.missNs << "\n";
+        cout << setw(10) << n << setw(10) << "unrolled" << setw(10) << unrolled.insertNs
+             << setw(10) << unrolled.hitNs << setw(10) << unrolled.missNs << "\n";
+    }
+    return 0;
+}